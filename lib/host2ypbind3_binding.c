@@ -19,9 +19,43 @@
 
 #if defined(HAVE_YPBIND3)
 
+#include <stdlib.h>
 #include <rpcsvc/yp_prot.h>
 #include "internal.h"
 
+/* Build the binding from the cache entry of host, if there is one.  */
+static struct ypbind3_binding *
+cached_binding (const char *host)
+{
+  char netid[32], uaddr[128];
+  ypbind3_binding ypb3, *res = NULL;
+  struct netconfig *nconf;
+  struct netbuf *nbuf;
+
+  if (__yp_bindcache_get (host, netid, sizeof (netid), uaddr,
+			  sizeof (uaddr)) != 0)
+    return NULL;
+  if ((nconf = getnetconfigent (netid)) == NULL)
+    return NULL;
+
+  if ((nbuf = uaddr2taddr (nconf, uaddr)) != NULL)
+    {
+      ypb3.ypbind_nconf = nconf;
+      ypb3.ypbind_svcaddr = nbuf;
+      ypb3.ypbind_servername = (char *)host;
+      ypb3.ypbind_hi_vers = YPVERS;
+      ypb3.ypbind_lo_vers = YPVERS;
+
+      res = __ypbind3_binding_dup (&ypb3);
+
+      free (nbuf->buf);
+      free (nbuf);
+    }
+  freenetconfigent (nconf);
+
+  return res;
+}
+
 struct ypbind3_binding *
 __host2ypbind3_binding (const char *host)
 {
@@ -30,6 +64,10 @@ __host2ypbind3_binding (const char *host)
   ypbind3_binding ypb3, *res;
   struct netconfig *nconf;
   struct netbuf nbuf;
+  char *uaddr;
+
+  if ((res = cached_binding (host)) != NULL)
+    return res;
 
   /* connect to server to find out if it exist and runs */
   if ((server = clnt_create_timed (host, YPPROG, YPVERS,
@@ -48,6 +86,12 @@ __host2ypbind3_binding (const char *host)
 
   res = __ypbind3_binding_dup (&ypb3);
 
+  if (res != NULL && (uaddr = taddr2uaddr (nconf, &nbuf)) != NULL)
+    {
+      __yp_bindcache_set (host, nconf->nc_netid, uaddr);
+      free (uaddr);
+    }
+
   freenetconfigent (nconf);
 
   clnt_destroy (server);
@@ -19,5 +19,21 @@
 extern struct ypbind3_binding *__host2ypbind3_binding (const char *__host);
 extern struct ypbind3_binding *__ypbind3_binding_dup (struct ypbind3_binding *__src);
 extern void __ypbind3_binding_free (struct ypbind3_binding *ypb);
+extern char *__yp_bound_server (const char *__domain, int *__err);
+extern char *__yp_cache_dir (int __create);
+extern const char *__yp_cache_host (const char *__host, char *__buf,
+				   size_t __buflen);
+extern u_long __yp_rpcvers_get (const char *__host, u_long __prog);
+extern void __yp_rpcvers_set (const char *__host, u_long __prog,
+			      u_long __vers);
+extern const char *__yp_addr2name (const struct sockaddr *__sa,
+				   socklen_t __salen, char *__buf,
+				   size_t __buflen);
+extern void __yp_addr2name_persist (void);
+extern int __yp_bindcache_get (const char *__host, char *__netid,
+			       size_t __netidlen, char *__uaddr,
+			       size_t __uaddrlen);
+extern void __yp_bindcache_set (const char *__host, const char *__netid,
+				const char *__uaddr);
 
 #endif
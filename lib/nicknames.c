@@ -45,6 +45,7 @@ struct ypalias
 };
 
 static struct ypalias *ypaliases = NULL;
+static int nicknames_loaded = 0;
 
 static void
 load_nicknames (void)
@@ -54,6 +55,9 @@ load_nicknames (void)
   size_t len;
   int i = 0;
 
+  /* Only try once, even if the file does not exist or is empty.  */
+  nicknames_loaded = 1;
+
   /* Open the nickname file.  */
   fp = fopen (NICKNAMEFILE, "r");
   if (fp == NULL)
@@ -121,7 +125,7 @@ getypalias (const char *alias)
 {
   struct ypalias *ptr;
 
-  if (ypaliases == NULL)
+  if (!nicknames_loaded)
     load_nicknames ();
 
   ptr = ypaliases;
@@ -140,7 +144,7 @@ print_nicknames (void)
 {
   struct ypalias *ptr;
 
-  if (ypaliases == NULL)
+  if (!nicknames_loaded)
     load_nicknames ();
 
   ptr = ypaliases;
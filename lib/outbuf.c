@@ -0,0 +1,187 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "outbuf.h"
+
+/* Write all iovecs, continue after partial writes.  */
+static int
+writev_all (int fd, struct iovec *iov, int iovcnt)
+{
+  while (iovcnt > 0)
+    {
+      ssize_t n = writev (fd, iov, iovcnt);
+
+      if (n < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return -1;
+	}
+
+      while (iovcnt > 0 && (size_t) n >= iov->iov_len)
+	{
+	  n -= iov->iov_len;
+	  ++iov;
+	  --iovcnt;
+	}
+      if (iovcnt > 0)
+	{
+	  iov->iov_base = (char *) iov->iov_base + n;
+	  iov->iov_len -= n;
+	}
+    }
+  return 0;
+}
+
+static int
+outbuf_write (struct outbuf *ob, struct iovec *iov, int iovcnt)
+{
+  int ret;
+
+  if (ob->lock)
+    pthread_mutex_lock (ob->lock);
+  ret = writev_all (ob->fd, iov, iovcnt);
+  if (ob->lock)
+    pthread_mutex_unlock (ob->lock);
+
+  return ret;
+}
+
+int
+outbuf_init (struct outbuf *ob, int fd, size_t size)
+{
+  memset (ob, 0, sizeof (struct outbuf));
+  ob->fd = fd;
+  ob->size = size ? size : OUTBUF_SIZE;
+  ob->buf = malloc (ob->size);
+  if (ob->buf == NULL)
+    return -1;
+  clock_gettime (CLOCK_MONOTONIC, &ob->start);
+  return 0;
+}
+
+int
+outbuf_put (struct outbuf *ob, const char *key, size_t keylen,
+	    const char *val, size_t vallen)
+{
+  size_t need = vallen + 1;
+
+  if (key != NULL)
+    need += keylen + 1;
+  if (ob->prefix != NULL)
+    need += ob->prefixlen + 1;
+
+  ob->records++;
+  ob->bytes += need;
+
+  if (need <= ob->size - ob->len)
+    {
+      char *p = ob->buf + ob->len;
+
+      if (ob->prefix != NULL)
+	{
+	  memcpy (p, ob->prefix, ob->prefixlen);
+	  p += ob->prefixlen;
+	  *p++ = ' ';
+	}
+      if (key != NULL)
+	{
+	  memcpy (p, key, keylen);
+	  p += keylen;
+	  *p++ = ' ';
+	}
+      memcpy (p, val, vallen);
+      p += vallen;
+      *p = '\n';
+      ob->len += need;
+      return 0;
+    }
+  else
+    {
+      /* Does not fit: write the buffer and this record directly
+	 with one writev, without copying the record first.  */
+      struct iovec iov[7];
+      int cnt = 0;
+
+      iov[cnt].iov_base = ob->buf;
+      iov[cnt++].iov_len = ob->len;
+      if (ob->prefix != NULL)
+	{
+	  iov[cnt].iov_base = (char *) ob->prefix;
+	  iov[cnt++].iov_len = ob->prefixlen;
+	  iov[cnt].iov_base = (char *) " ";
+	  iov[cnt++].iov_len = 1;
+	}
+      if (key != NULL)
+	{
+	  iov[cnt].iov_base = (char *) key;
+	  iov[cnt++].iov_len = keylen;
+	  iov[cnt].iov_base = (char *) " ";
+	  iov[cnt++].iov_len = 1;
+	}
+      iov[cnt].iov_base = (char *) val;
+      iov[cnt++].iov_len = vallen;
+      iov[cnt].iov_base = (char *) "\n";
+      iov[cnt++].iov_len = 1;
+
+      ob->len = 0;
+      return outbuf_write (ob, iov, cnt);
+    }
+}
+
+int
+outbuf_flush (struct outbuf *ob)
+{
+  struct iovec iov;
+
+  if (ob->len == 0)
+    return 0;
+
+  iov.iov_base = ob->buf;
+  iov.iov_len = ob->len;
+  ob->len = 0;
+
+  return outbuf_write (ob, &iov, 1);
+}
+
+void
+outbuf_destroy (struct outbuf *ob)
+{
+  free (ob->buf);
+  ob->buf = NULL;
+  ob->len = ob->size = 0;
+}
+
+double
+outbuf_elapsed (const struct outbuf *ob)
+{
+  struct timespec now;
+
+  clock_gettime (CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - ob->start.tv_sec) +
+    (now.tv_nsec - ob->start.tv_nsec) / 1e9;
+}
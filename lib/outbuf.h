@@ -0,0 +1,56 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifndef __OUTBUF_H__
+#define __OUTBUF_H__
+
+#include <stddef.h>
+#include <time.h>
+#include <pthread.h>
+
+#define OUTBUF_SIZE (256 * 1024)
+
+/* Collects "key value\n" records in a large buffer and writes them
+   out with writev, instead of formatting every record with stdio.  */
+struct outbuf
+{
+  int fd;
+  char *buf;
+  size_t len;
+  size_t size;
+  unsigned long long records;
+  unsigned long long bytes;
+  struct timespec start;
+  /* Optional, written in front of every record, separated by a
+     blank.  */
+  const char *prefix;
+  size_t prefixlen;
+  /* Optional, held while writing, if several buffers share one
+     file descriptor. Only complete records are written.  */
+  pthread_mutex_t *lock;
+};
+
+extern int outbuf_init (struct outbuf *ob, int fd, size_t size);
+/* Append one record. If key is NULL, only the value is written.  */
+extern int outbuf_put (struct outbuf *ob, const char *key, size_t keylen,
+		       const char *val, size_t vallen);
+extern int outbuf_flush (struct outbuf *ob);
+extern void outbuf_destroy (struct outbuf *ob);
+/* Seconds since outbuf_init.  */
+extern double outbuf_elapsed (const struct outbuf *ob);
+
+#endif /* __OUTBUF_H__ */
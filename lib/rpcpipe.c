@@ -0,0 +1,493 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <poll.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <rpc/rpc.h>
+#include "rpcpipe.h"
+
+#define RECVSIZE 65536
+
+/* One call in flight. The XID of a call is the slot number in the
+   lower 16 bits and a counter in the upper bits, so an answer can
+   be found without searching.  */
+struct slot
+{
+  struct rpcpipe_call call;
+  u_int32_t xid;
+  int busy;
+  struct timeval resend;
+  struct timeval interval;
+  struct timeval deadline;
+};
+
+static void
+pipe_init (struct rpcpipe *pipe)
+{
+  struct timeval now;
+
+  pipe->timeout.tv_sec = 25;
+  pipe->retry.tv_sec = 1;
+  gettimeofday (&now, NULL);
+  pipe->xid = (getpid () ^ now.tv_sec ^ now.tv_usec) << 16;
+}
+
+struct rpcpipe *
+rpcpipe_create (const char *host, u_long prog, u_long vers)
+{
+  struct rpcpipe *pipe;
+
+  pipe = calloc (1, sizeof (struct rpcpipe));
+  if (pipe == NULL)
+    return NULL;
+
+  /* Let the RPC library do the portmapper lookup, we only
+     borrow the socket and the address of the server.  */
+  pipe->clnt = clnt_create (host, prog, vers, "udp");
+  if (pipe->clnt == NULL)
+    {
+      free (pipe);
+      return NULL;
+    }
+
+  pipe->auth = pipe->clnt->cl_auth;
+  if (!clnt_control (pipe->clnt, CLGET_FD, (char *) &pipe->fd))
+    goto fail;
+#if defined(HAVE_TIRPC)
+  {
+    struct netbuf nbuf;
+
+    if (!clnt_control (pipe->clnt, CLGET_SVC_ADDR, (char *) &nbuf) ||
+	nbuf.len > sizeof (pipe->addr))
+      goto fail;
+    memcpy (&pipe->addr, nbuf.buf, nbuf.len);
+    pipe->addrlen = nbuf.len;
+  }
+#else
+  {
+    struct sockaddr_in sin;
+
+    if (!clnt_control (pipe->clnt, CLGET_SERVER_ADDR, (char *) &sin))
+      goto fail;
+    memcpy (&pipe->addr, &sin, sizeof (sin));
+    pipe->addrlen = sizeof (sin);
+  }
+#endif
+
+  pipe->family = ((struct sockaddr *) &pipe->addr)->sa_family;
+  pipe->prog = prog;
+  pipe->vers = vers;
+  pipe_init (pipe);
+
+  return pipe;
+
+ fail:
+  clnt_destroy (pipe->clnt);
+  free (pipe);
+  return NULL;
+}
+
+struct rpcpipe *
+rpcpipe_open (void)
+{
+  struct rpcpipe *pipe;
+  int off = 0;
+
+  pipe = calloc (1, sizeof (struct rpcpipe));
+  if (pipe == NULL)
+    return NULL;
+
+  /* One IPv6 socket can reach IPv4 hosts, too. */
+  pipe->family = AF_INET6;
+  pipe->fd = socket (AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (pipe->fd < 0 ||
+      setsockopt (pipe->fd, IPPROTO_IPV6, IPV6_V6ONLY, &off,
+		  sizeof (off)) != 0)
+    {
+      if (pipe->fd >= 0)
+	close (pipe->fd);
+      pipe->family = AF_INET;
+      pipe->fd = socket (AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    }
+  if (pipe->fd < 0 || (pipe->auth = authnone_create ()) == NULL)
+    {
+      if (pipe->fd >= 0)
+	close (pipe->fd);
+      free (pipe);
+      return NULL;
+    }
+  pipe_init (pipe);
+
+  return pipe;
+}
+
+int
+rpcpipe_bindresvport (struct rpcpipe *pipe)
+{
+#ifdef HAVE_TIRPC
+  return bindresvport_sa (pipe->fd, NULL);
+#else
+  struct sockaddr_storage ss;
+  struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &ss;
+  int port;
+
+  if (pipe->family == AF_INET)
+    return bindresvport (pipe->fd, NULL);
+
+  /* The old Sun RPC of glibc knows only IPv4.  */
+  memset (&ss, 0, sizeof (ss));
+  sin6->sin6_family = AF_INET6;
+  sin6->sin6_addr = in6addr_any;
+  for (port = IPPORT_RESERVED - 1; port >= IPPORT_RESERVED / 2; port--)
+    {
+      sin6->sin6_port = htons (port);
+      if (bind (pipe->fd, (struct sockaddr *) sin6, sizeof (*sin6)) == 0)
+	return 0;
+      if (errno != EADDRINUSE)
+	return -1;
+    }
+  errno = EADDRINUSE;
+  return -1;
+#endif
+}
+
+void
+rpcpipe_destroy (struct rpcpipe *pipe)
+{
+  if (pipe == NULL)
+    return;
+  if (pipe->clnt)
+    clnt_destroy (pipe->clnt);
+  else
+    {
+      AUTH_DESTROY (pipe->auth);
+      close (pipe->fd);
+    }
+  free (pipe);
+}
+
+static int
+send_call (struct rpcpipe *pipe, struct slot *s)
+{
+  char buf[UDPMSGSIZE];
+  struct rpc_msg msg;
+  u_int32_t proc = s->call.proc;
+  const struct sockaddr *addr = (struct sockaddr *) &pipe->addr;
+  socklen_t addrlen = pipe->addrlen;
+  struct sockaddr_in6 sin6;
+  XDR xdrs;
+  u_int len;
+
+  if (s->call.addr != NULL)
+    {
+      addr = s->call.addr;
+      addrlen = s->call.addrlen;
+    }
+  if (addrlen == 0)
+    return RPC_UNKNOWNADDR;
+  /* IPv4 address for the IPv6 socket of rpcpipe_open */
+  if (pipe->family == AF_INET6 && addr->sa_family == AF_INET)
+    {
+      const struct sockaddr_in *sin = (const struct sockaddr_in *) addr;
+
+      memset (&sin6, 0, sizeof (sin6));
+      sin6.sin6_family = AF_INET6;
+      sin6.sin6_port = sin->sin_port;
+      sin6.sin6_addr.s6_addr[10] = 0xff;
+      sin6.sin6_addr.s6_addr[11] = 0xff;
+      memcpy (&sin6.sin6_addr.s6_addr[12], &sin->sin_addr, 4);
+      addr = (struct sockaddr *) &sin6;
+      addrlen = sizeof (sin6);
+    }
+  else if (addr->sa_family != pipe->family)
+    return RPC_UNKNOWNADDR;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.rm_xid = s->xid;
+  msg.rm_direction = CALL;
+  msg.rm_call.cb_rpcvers = RPC_MSG_VERSION;
+  msg.rm_call.cb_prog = s->call.prog ? s->call.prog : pipe->prog;
+  msg.rm_call.cb_vers = s->call.vers ? s->call.vers : pipe->vers;
+
+  xdrmem_create (&xdrs, buf, sizeof (buf), XDR_ENCODE);
+  if (!xdr_callhdr (&xdrs, &msg) ||
+      !xdr_u_int32_t (&xdrs, &proc) ||
+      !AUTH_MARSHALL (pipe->auth, &xdrs) ||
+      !(*s->call.inproc) (&xdrs, s->call.in))
+    {
+      xdr_destroy (&xdrs);
+      return RPC_CANTENCODEARGS;
+    }
+  len = XDR_GETPOS (&xdrs);
+  xdr_destroy (&xdrs);
+
+  /* If the packet gets lost here, the retransmission will fix it.  */
+  sendto (pipe->fd, buf, len, 0, addr, addrlen);
+
+  return RPC_SUCCESS;
+}
+
+static void
+decode_reply (struct slot *s, char *buf, size_t len)
+{
+  struct rpc_msg reply;
+  struct rpc_err err;
+  XDR xdrs;
+
+  memset (&reply, 0, sizeof (reply));
+  reply.acpted_rply.ar_verf = _null_auth;
+  reply.acpted_rply.ar_results.where = s->call.out;
+  reply.acpted_rply.ar_results.proc = s->call.outproc;
+
+  xdrmem_create (&xdrs, buf, len, XDR_DECODE);
+  if (xdr_replymsg (&xdrs, &reply))
+    {
+      _seterr_reply (&reply, &err);
+      s->call.stat = err.re_status;
+      if (reply.rm_reply.rp_stat == MSG_ACCEPTED &&
+	  reply.acpted_rply.ar_verf.oa_base != NULL)
+	{
+	  xdrs.x_op = XDR_FREE;
+	  xdr_opaque_auth (&xdrs, &reply.acpted_rply.ar_verf);
+	}
+    }
+  else
+    s->call.stat = RPC_CANTDECODERES;
+  xdr_destroy (&xdrs);
+
+  if (s->call.stat != RPC_SUCCESS)
+    xdr_free (s->call.outproc, s->call.out);
+}
+
+static int
+tv_cmp (const struct timeval *a, const struct timeval *b)
+{
+  if (a->tv_sec != b->tv_sec)
+    return a->tv_sec < b->tv_sec ? -1 : 1;
+  if (a->tv_usec != b->tv_usec)
+    return a->tv_usec < b->tv_usec ? -1 : 1;
+  return 0;
+}
+
+int
+rpcpipe_run (struct rpcpipe *pipe, unsigned int window,
+	     rpcpipe_next_t next, rpcpipe_done_t done, void *data)
+{
+  struct slot *slots;
+  unsigned int *freelist, nfree, inflight = 0, i;
+  char *buf;
+  int ret = 0;
+
+  if (window == 0)
+    window = 1;
+  if (window > RPCPIPE_MAXWINDOW)
+    window = RPCPIPE_MAXWINDOW;
+
+  slots = calloc (window, sizeof (struct slot));
+  freelist = calloc (window, sizeof (unsigned int));
+  buf = malloc (RECVSIZE);
+  if (slots == NULL || freelist == NULL || buf == NULL)
+    {
+      free (slots);
+      free (freelist);
+      free (buf);
+      return -1;
+    }
+  for (nfree = 0; nfree < window; nfree++)
+    freelist[nfree] = window - nfree - 1;
+
+  while (1)
+    {
+      struct timeval now, wait;
+      struct pollfd pfd;
+      int timeout;
+
+      gettimeofday (&now, NULL);
+
+      /* done may have queued new calls, so ask next again
+	 every time a slot is free.  */
+      while (nfree > 0)
+	{
+	  struct slot *s = &slots[freelist[nfree - 1]];
+
+	  memset (&s->call, 0, sizeof (s->call));
+	  if (!(*next) (data, &s->call))
+	    break;
+	  --nfree;
+	  pipe->xid += 1 << 16;
+	  s->xid = (pipe->xid & 0xffff0000) | (u_int32_t) (s - slots);
+	  s->interval = pipe->retry;
+	  timeradd (&now, &s->interval, &s->resend);
+	  if (timerisset (&s->call.timeout))
+	    timeradd (&now, &s->call.timeout, &s->deadline);
+	  else
+	    timeradd (&now, &pipe->timeout, &s->deadline);
+	  s->call.stat = send_call (pipe, s);
+	  if (s->call.stat != RPC_SUCCESS)
+	    {
+	      freelist[nfree++] = s - slots;
+	      (*done) (data, &s->call);
+	      continue;
+	    }
+	  s->busy = 1;
+	  ++inflight;
+	}
+
+      if (inflight == 0)
+	break;
+
+      /* Sleep until the next retransmission or deadline.  */
+      wait.tv_sec = 3600;
+      wait.tv_usec = 0;
+      for (i = 0; i < window; i++)
+	if (slots[i].busy)
+	  {
+	    const struct timeval *t =
+	      tv_cmp (&slots[i].resend, &slots[i].deadline) < 0 ?
+	      &slots[i].resend : &slots[i].deadline;
+	    struct timeval diff;
+
+	    if (tv_cmp (t, &now) <= 0)
+	      timerclear (&diff);
+	    else
+	      timersub (t, &now, &diff);
+	    if (tv_cmp (&diff, &wait) < 0)
+	      wait = diff;
+	  }
+      timeout = wait.tv_sec * 1000 + (wait.tv_usec + 999) / 1000;
+
+      pfd.fd = pipe->fd;
+      pfd.events = POLLIN;
+      if (poll (&pfd, 1, timeout) < 0 && errno != EINTR)
+	{
+	  ret = -1;
+	  break;
+	}
+
+      if (pfd.revents & POLLIN)
+	{
+	  ssize_t n;
+
+	  while ((n = recv (pipe->fd, buf, RECVSIZE, MSG_DONTWAIT)) >= 4)
+	    {
+	      u_int32_t xid;
+	      struct slot *s;
+
+	      memcpy (&xid, buf, sizeof (xid));
+	      xid = ntohl (xid);
+	      if ((xid & 0xffff) >= window)
+		continue;
+	      s = &slots[xid & 0xffff];
+	      /* Duplicate or late answer to a retransmission */
+	      if (!s->busy || s->xid != xid)
+		continue;
+
+	      decode_reply (s, buf, n);
+	      s->busy = 0;
+	      --inflight;
+	      freelist[nfree++] = s - slots;
+	      (*done) (data, &s->call);
+	    }
+	}
+
+      gettimeofday (&now, NULL);
+      for (i = 0; i < window; i++)
+	{
+	  struct slot *s = &slots[i];
+
+	  if (!s->busy)
+	    continue;
+	  if (tv_cmp (&s->deadline, &now) <= 0)
+	    {
+	      s->call.stat = RPC_TIMEDOUT;
+	      s->busy = 0;
+	      --inflight;
+	      freelist[nfree++] = i;
+	      (*done) (data, &s->call);
+	    }
+	  else if (tv_cmp (&s->resend, &now) <= 0)
+	    {
+	      send_call (pipe, s);
+	      timeradd (&s->interval, &s->interval, &s->interval);
+	      timeradd (&now, &s->interval, &s->resend);
+	    }
+	}
+    }
+
+  /* Only on errors, tell the caller about the lost calls.  */
+  for (i = 0; i < window; i++)
+    if (slots[i].busy)
+      {
+	slots[i].call.stat = RPC_CANTRECV;
+	(*done) (data, &slots[i].call);
+      }
+
+  free (slots);
+  free (freelist);
+  free (buf);
+
+  return ret;
+}
+
+struct batch
+{
+  struct rpcpipe_call *calls;
+  size_t ncalls;
+  size_t next;
+};
+
+static int
+batch_next (void *data, struct rpcpipe_call *call)
+{
+  struct batch *b = data;
+
+  if (b->next >= b->ncalls)
+    return 0;
+  *call = b->calls[b->next];
+  call->data = &b->calls[b->next];
+  b->next++;
+  return 1;
+}
+
+static void
+batch_done (void *data __attribute__ ((unused)), struct rpcpipe_call *call)
+{
+  struct rpcpipe_call *orig = call->data;
+
+  orig->stat = call->stat;
+}
+
+int
+rpcpipe_batch (struct rpcpipe *pipe, struct rpcpipe_call *calls,
+	       size_t ncalls, unsigned int window)
+{
+  struct batch b = {calls, ncalls, 0};
+
+  if (window == 0 || window > ncalls)
+    window = ncalls;
+
+  return rpcpipe_run (pipe, window, batch_next, batch_done, &b);
+}
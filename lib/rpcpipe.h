@@ -0,0 +1,91 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifndef __RPCPIPE_H__
+#define __RPCPIPE_H__
+
+#include <sys/socket.h>
+#include <rpc/rpc.h>
+
+/* Sends many RPC calls over one UDP socket without waiting for the
+   answers. Answers are matched to the calls by the XID.  */
+
+struct rpcpipe_call
+{
+  u_long proc;
+  xdrproc_t inproc;
+  caddr_t in;
+  xdrproc_t outproc;
+  caddr_t out;
+  /* If set, used instead of the server, program, version and
+     timeout of the pipe.  */
+  const struct sockaddr *addr;
+  socklen_t addrlen;
+  u_long prog;
+  u_long vers;
+  struct timeval timeout;
+  /* Set before done is called. out is only valid and must be freed
+     by the caller if stat is RPC_SUCCESS.  */
+  enum clnt_stat stat;
+  /* For the caller.  */
+  void *data;
+};
+
+/* Fill in the next call. Return 0 if there is none at the moment,
+   rpcpipe_run returns if there is none and no call is in flight.  */
+typedef int (*rpcpipe_next_t) (void *data, struct rpcpipe_call *call);
+/* The answer for call arrived, or it failed.  */
+typedef void (*rpcpipe_done_t) (void *data, struct rpcpipe_call *call);
+
+struct rpcpipe
+{
+  CLIENT *clnt;
+  AUTH *auth;
+  int fd;
+  int family;
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+  u_long prog;
+  u_long vers;
+  u_int32_t xid;
+  /* Time until a call fails, and the time until the first
+     retransmission, which doubles for every further one.  */
+  struct timeval timeout;
+  struct timeval retry;
+};
+
+#define RPCPIPE_MAXWINDOW 65535
+
+extern struct rpcpipe *rpcpipe_create (const char *host, u_long prog,
+				       u_long vers);
+/* A pipe without a server, every call needs its own address. */
+extern struct rpcpipe *rpcpipe_open (void);
+extern void rpcpipe_destroy (struct rpcpipe *pipe);
+/* Bind the socket of the pipe to a reserved port, for calls which
+   the server only accepts from root. Returns -1 with errno set if
+   this is not possible.  */
+extern int rpcpipe_bindresvport (struct rpcpipe *pipe);
+/* Keep up to window calls in flight, until next returns 0 and all
+   answers arrived or timed out. done may queue new calls.  */
+extern int rpcpipe_run (struct rpcpipe *pipe, unsigned int window,
+			rpcpipe_next_t next, rpcpipe_done_t done,
+			void *data);
+/* Send all calls at once and wait for all answers.  */
+extern int rpcpipe_batch (struct rpcpipe *pipe, struct rpcpipe_call *calls,
+			  size_t ncalls, unsigned int window);
+
+#endif /* __RPCPIPE_H__ */
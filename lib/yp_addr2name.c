@@ -0,0 +1,231 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This library is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   in version 2.1 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <time.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <rpc/rpc.h>
+#include "internal.h"
+#include "yp_cachefile.h"
+
+/* Reverse lookups run in a thread. The caller waits at most
+   NAME_TIMEOUT seconds and prints the numeric address if the
+   resolver is slow, the name is still stored for later calls.
+   Names are kept for the whole process, and with
+   __yp_addr2name_persist for NAME_TTL seconds in the cache
+   directory.  */
+#define NAME_TIMEOUT 2
+#define NAME_TTL (60 * 60)
+#define NAME_FILE "names"
+
+struct name_entry
+{
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+  char numeric[NI_MAXHOST];
+  /* NULL if the address has no name */
+  char *name;
+  int pending;
+  /* Somebody already waited in vain for the resolver */
+  int timedout;
+  time_t stamp;
+  struct name_entry *next;
+};
+
+static pthread_mutex_t name_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t name_cond = PTHREAD_COND_INITIALIZER;
+static struct name_entry *name_list;
+static int name_persist;
+
+static void name_parse (const char *line, time_t now);
+static void name_format (FILE *fp, time_t now);
+
+static struct yp_cachefile name_file =
+{
+  NAME_FILE, name_parse, name_format, &name_lock, 0, 0, 0, NULL
+};
+
+static struct name_entry *
+name_find (const char *numeric)
+{
+  struct name_entry *e;
+
+  for (e = name_list; e; e = e->next)
+    if (strcmp (e->numeric, numeric) == 0)
+      return e;
+  return NULL;
+}
+
+static struct name_entry *
+name_add (const char *numeric)
+{
+  struct name_entry *e = calloc (1, sizeof (struct name_entry));
+
+  if (e == NULL)
+    return NULL;
+  snprintf (e->numeric, sizeof (e->numeric), "%s", numeric);
+  e->next = name_list;
+  name_list = e;
+  return e;
+}
+
+/* Called with name_lock held.  */
+static void
+name_parse (const char *line, time_t now)
+{
+  char numeric[NI_MAXHOST], name[NI_MAXHOST];
+  struct name_entry *e;
+  long long stamp;
+
+  if (sscanf (line, "%1024s %1024s %lld", numeric, name, &stamp) != 3 ||
+      stamp > now || now - stamp >= NAME_TTL)
+    return;
+  e = name_find (numeric);
+  if (e == NULL)
+    {
+      if ((e = name_add (numeric)) == NULL)
+	return;
+    }
+  else if (e->pending || e->stamp >= stamp)
+    return;
+  free (e->name);
+  e->name = strdup (name);
+  e->stamp = stamp;
+}
+
+/* Called with name_lock held at exit. Resolver threads which did
+   not finish yet may still run, their names are not written and
+   are looked up again by the next process.  Timeouts are not
+   written either, they should be tried again.  */
+static void
+name_format (FILE *fp, time_t now)
+{
+  struct name_entry *e;
+
+  for (e = name_list; e; e = e->next)
+    if (!e->pending && e->name != NULL && now - e->stamp < NAME_TTL)
+      fprintf (fp, "%s %s %lld\n", e->numeric, e->name,
+	       (long long) e->stamp);
+}
+
+static void *
+name_thread (void *arg)
+{
+  struct name_entry *e = arg;
+  char host[NI_MAXHOST];
+  int res;
+
+  res = getnameinfo ((struct sockaddr *) &e->addr, e->addrlen,
+		     host, sizeof (host), NULL, 0, NI_NAMEREQD);
+
+  pthread_mutex_lock (&name_lock);
+  if (res == 0)
+    {
+      e->name = strdup (host);
+      if (name_persist && e->name != NULL)
+	__yp_cachefile_changed (&name_file);
+    }
+  e->stamp = time (NULL);
+  e->pending = 0;
+  pthread_cond_broadcast (&name_cond);
+  pthread_mutex_unlock (&name_lock);
+
+  return NULL;
+}
+
+/* Write the host name of sa into buf, or the numeric address if
+   there is none or the resolver did not answer in time. Returns
+   buf, or NULL if not even the numeric address can be printed.  */
+const char *
+__yp_addr2name (const struct sockaddr *sa, socklen_t salen, char *buf,
+		size_t buflen)
+{
+  char numeric[NI_MAXHOST];
+  struct name_entry *e;
+  struct timespec deadline;
+
+  if (salen > sizeof (struct sockaddr_storage) ||
+      getnameinfo (sa, salen, numeric, sizeof (numeric), NULL, 0,
+		   NI_NUMERICHOST) != 0)
+    return NULL;
+
+  pthread_mutex_lock (&name_lock);
+  if (name_persist)
+    __yp_cachefile_load (&name_file);
+
+  e = name_find (numeric);
+  if (e == NULL)
+    {
+      pthread_attr_t attr;
+      pthread_t tid;
+
+      if ((e = name_add (numeric)) == NULL)
+	goto numeric;
+      memcpy (&e->addr, sa, salen);
+      e->addrlen = salen;
+      e->pending = 1;
+
+      pthread_attr_init (&attr);
+      pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+      if (pthread_create (&tid, &attr, name_thread, e) != 0)
+	{
+	  /* Without a thread, wait for the resolver */
+	  pthread_mutex_unlock (&name_lock);
+	  name_thread (e);
+	  pthread_mutex_lock (&name_lock);
+	}
+      pthread_attr_destroy (&attr);
+    }
+
+  /* Wait only once for a slow resolver, not for every host
+     which is bound to the same server.  */
+  clock_gettime (CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += NAME_TIMEOUT;
+  while (e->pending && !e->timedout)
+    if (pthread_cond_timedwait (&name_cond, &name_lock, &deadline) != 0)
+      e->timedout = 1;
+
+  if (!e->pending && e->name != NULL)
+    {
+      snprintf (buf, buflen, "%s", e->name);
+      pthread_mutex_unlock (&name_lock);
+      return buf;
+    }
+
+ numeric:
+  pthread_mutex_unlock (&name_lock);
+  snprintf (buf, buflen, "%s", numeric);
+  return buf;
+}
+
+/* Keep the names in the cache directory, too. Useful if the same
+   servers are printed by many runs.  */
+void
+__yp_addr2name_persist (void)
+{
+  pthread_mutex_lock (&name_lock);
+  name_persist = 1;
+  __yp_cachefile_load (&name_file);
+  pthread_mutex_unlock (&name_lock);
+}
@@ -22,6 +22,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <netdb.h>
@@ -33,76 +34,182 @@
 
 static struct timeval RPCTIMEOUT = {10, 0};
 
-static void *ypall_data;
-static int (*ypall_foreach) (int status, char *key, int keylen,
-                             char *val, int vallen, char *data);
+/* Buffer the records of one YPPROC_ALL stream are decoded into.
+   It is allocated once per stream and only grows if a record does
+   not fit, so decoding a map does not cost a malloc/free per entry.  */
+struct ypall_arena
+{
+  char *buf;
+  u_int size;
+};
+
+/* Everything __xdr_ypresp_all needs. It is handed to clnt_call as
+   result pointer, so concurrent streams don't share any state.  */
+struct ypall_stream
+{
+  const struct ypall_callback *callback;
+  u_long status;
+  struct ypall_arena arena;
+};
+
+static bool_t
+ypall_arena_reserve (struct ypall_arena *arena, u_int len)
+{
+  char *p;
+  u_int size;
+
+  if (len <= arena->size)
+    return TRUE;
+
+  size = arena->size ? arena->size : 2 * (YPMAXRECORD + 1);
+  while (size < len)
+    size *= 2;
+
+  p = realloc (arena->buf, size);
+  if (p == NULL)
+    return FALSE;
+  arena->buf = p;
+  arena->size = size;
+
+  return TRUE;
+}
+
+/* Decode one counted opaque (keydat or valdat) directly from the
+   XDR stream into the arena at offset *off, followed by an extra
+   NUL byte.  *off is advanced behind that NUL.  */
+static bool_t
+ypall_getbytes (XDR *xdrs, struct ypall_arena *arena, u_int *off,
+		u_int *lenp)
+{
+  static char crud[BYTES_PER_XDR_UNIT];
+  u_int len, rndup;
+
+  if (!xdr_u_int (xdrs, &len) || len > YPMAXRECORD)
+    return FALSE;
 
+  if (!ypall_arena_reserve (arena, *off + len + 1))
+    return FALSE;
+
+  if (len > 0 && !XDR_GETBYTES (xdrs, arena->buf + *off, len))
+    return FALSE;
+
+  rndup = len % BYTES_PER_XDR_UNIT;
+  if (rndup > 0 &&
+      !XDR_GETBYTES (xdrs, crud, BYTES_PER_XDR_UNIT - rndup))
+    return FALSE;
+
+  arena->buf[*off + len] = '\0';
+  *lenp = len;
+  *off += len + 1;
+
+  return TRUE;
+}
+
+/* Decode the ypresp_all stream record by record. Key and value are
+   read into one arena and the callback gets pointers into it, instead
+   of going through xdr_ypresp_all and copying every record again.  */
 static bool_t
-__xdr_ypresp_all (XDR *xdrs, u_long *objp)
+__xdr_ypresp_all (XDR *xdrs, struct ypall_stream *objp)
 {
+  struct ypall_arena *arena = &objp->arena;
+  int (*foreach) (int, char *, int, char *, int, char *) =
+    objp->callback->foreach;
+  char *data = objp->callback->data;
+
   while (1)
     {
-      struct ypresp_all resp;
-
-      memset (&resp, '\0', sizeof (struct ypresp_all));
-      if (!xdr_ypresp_all (xdrs, &resp))
-        {
-          xdr_free ((xdrproc_t) xdr_ypresp_all, (char *) &resp);
-          *objp = YP_YPERR;
-          return FALSE;
-        }
-      if (resp.more == 0)
-        {
-          xdr_free ((xdrproc_t) xdr_ypresp_all, (char *) &resp);
-          *objp = YP_NOMORE;
-          return TRUE;
-        }
-
-      switch (resp.ypresp_all_u.val.status)
-        {
-        case YP_TRUE:
-          {
-            char key[resp.ypresp_all_u.val.keydat.keydat_len + 1];
-            char val[resp.ypresp_all_u.val.valdat.valdat_len + 1];
-            int keylen = resp.ypresp_all_u.val.keydat.keydat_len;
-            int vallen = resp.ypresp_all_u.val.valdat.valdat_len;
-
-            /* We are not allowed to modify the key and val data.
-               But we are allowed to add data behind the buffer,
-               if we don't modify the length. So add an extra NUL
-               character to avoid trouble with broken code. */
-            *objp = YP_TRUE;
-            memcpy (key, resp.ypresp_all_u.val.keydat.keydat_val, keylen);
-            key[keylen] = '\0';
-            memcpy (val, resp.ypresp_all_u.val.valdat.valdat_val, vallen);
-            val[vallen] = '\0';
-            xdr_free ((xdrproc_t) xdr_ypresp_all, (char *) &resp);
-            if ((*ypall_foreach) (*objp, key, keylen,
-                                  val, vallen, ypall_data))
-              return TRUE;
-          }
-          break;
-        default:
-          *objp = resp.ypresp_all_u.val.status;
-          xdr_free ((xdrproc_t) xdr_ypresp_all, (char *) &resp);
-          /* Sun says we don't need to make this call, but must return
-             immediatly. Since Solaris makes this call, we will call
-             the callback function, too. */
-          (*ypall_foreach) (*objp, NULL, 0, NULL, 0, ypall_data);
-          return TRUE;
-        }
+      bool_t more;
+      enum ypstat status;
+      u_int off = 0, keyoff, keylen, vallen;
+
+      if (!xdr_bool (xdrs, &more))
+	{
+	  objp->status = YP_YPERR;
+	  return FALSE;
+	}
+      if (!more)
+	{
+	  objp->status = YP_NOMORE;
+	  return TRUE;
+	}
+
+      /* Value is transmitted before the key. We are not allowed
+	 to modify the key and val data. But we are allowed to add
+	 data behind the buffer, if we don't modify the length. So
+	 ypall_getbytes adds an extra NUL character to avoid trouble
+	 with broken code.  */
+      if (!xdr_ypstat (xdrs, &status) ||
+	  !ypall_getbytes (xdrs, arena, &off, &vallen))
+	{
+	  objp->status = YP_YPERR;
+	  return FALSE;
+	}
+      keyoff = off;
+      if (!ypall_getbytes (xdrs, arena, &off, &keylen))
+	{
+	  objp->status = YP_YPERR;
+	  return FALSE;
+	}
+
+      if (status == YP_TRUE)
+	{
+	  objp->status = YP_TRUE;
+	  if ((*foreach) (YP_TRUE, arena->buf + keyoff, keylen,
+			  arena->buf, vallen, data))
+	    return TRUE;
+	}
+      else
+	{
+	  objp->status = status;
+	  /* Sun says we don't need to make this call, but must return
+	     immediatly. Since Solaris makes this call, we will call
+	     the callback function, too. */
+	  (*foreach) (status, NULL, 0, NULL, 0, data);
+	  return TRUE;
+	}
     }
 }
 
+int
+yp_all_clnt (CLIENT *clnt, const char *indomain, const char *inmap,
+	     const struct ypall_callback *incallback)
+{
+  struct ypreq_nokey req;
+  struct ypall_stream stream;
+  enum clnt_stat result;
+
+  if (clnt == NULL || incallback == NULL ||
+      indomain == NULL || indomain[0] == '\0' ||
+      inmap == NULL || inmap[0] == '\0')
+    return YPERR_BADARGS;
+
+  req.domain = (char *) indomain;
+  req.map = (char *) inmap;
+
+  memset (&stream, 0, sizeof (stream));
+  stream.callback = incallback;
+
+  result = clnt_call (clnt, YPPROC_ALL, (xdrproc_t) xdr_ypreq_nokey,
+		      (caddr_t) &req, (xdrproc_t) __xdr_ypresp_all,
+		      (caddr_t) &stream, RPCTIMEOUT);
+
+  free (stream.arena.buf);
+
+  if (result != RPC_SUCCESS)
+    return YPERR_RPC;
+
+  if (stream.status != YP_NOMORE)
+    return ypprot_err (stream.status);
+
+  return YPERR_SUCCESS;
+}
+
 int
 yp_all_host (const char *indomain, const char *inmap,
 	     const struct ypall_callback *incallback, const char *hostname)
 {
-  struct ypreq_nokey req;
   int res;
-  enum clnt_stat result;
   CLIENT *clnt;
-  long status = 0;
 #if !defined(HAVE_TIRPC)
   int clnt_sock;
   struct sockaddr_in clnt_sin;
@@ -113,8 +220,6 @@ yp_all_host (const char *indomain, const char *inmap,
       inmap == NULL || inmap[0] == '\0')
     return YPERR_BADARGS;
 
-  res = YPERR_YPERR;
-
 #if defined(HAVE_TIRPC)
   clnt = clnt_create_timed (hostname, YPPROG, YPVERS, "tcp", NULL);
   if (clnt == NULL)
@@ -122,13 +227,19 @@ yp_all_host (const char *indomain, const char *inmap,
 #else
   clnt_sock = RPC_ANYSOCK;
 
+  memset (&clnt_sin, 0, sizeof (clnt_sin));
   if (inet_aton (hostname, &clnt_sin.sin_addr) == 0)
     {
-      struct hostent *host  = gethostbyname (hostname);
-      if (!host)
+      /* gethostbyname is not reentrant, use getaddrinfo instead */
+      struct addrinfo hints, *ai;
+
+      memset (&hints, 0, sizeof (hints));
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+      if (getaddrinfo (hostname, NULL, &hints, &ai) != 0)
         return YPERR_BADARGS;
-      memcpy (&clnt_sin.sin_addr, host->h_addr_list[0],
-              sizeof (clnt_sin.sin_addr));
+      clnt_sin.sin_addr = ((struct sockaddr_in *) ai->ai_addr)->sin_addr;
+      freeaddrinfo (ai);
     }
   clnt_sin.sin_family = AF_INET;
 
@@ -138,25 +249,9 @@ yp_all_host (const char *indomain, const char *inmap,
     return YPERR_PMAP;
 #endif
 
-  req.domain = (char *) indomain;
-  req.map = (char *) inmap;
-
-  ypall_foreach = incallback->foreach;
-  ypall_data = (void *) incallback->data;
-
-  result = clnt_call (clnt, YPPROC_ALL, (xdrproc_t) xdr_ypreq_nokey,
-		      (caddr_t) &req, (xdrproc_t) __xdr_ypresp_all,
-		      (caddr_t) &status, RPCTIMEOUT);
-
-  if (result != RPC_SUCCESS)
-    res = YPERR_RPC;
-  else
-    res = YPERR_SUCCESS;
+  res = yp_all_clnt (clnt, indomain, inmap, incallback);
 
   clnt_destroy (clnt);
 
-  if (res == YPERR_SUCCESS && status != YP_NOMORE)
-    return ypprot_err (status);
-
   return res;
 }
@@ -22,4 +22,12 @@ extern int yp_all_host (const char *indomain, const char *inmap,
 			const struct ypall_callback *incallback,
 			const char *hostname);
 
+/* Same as yp_all_host, but use an already created TCP client to
+   ypserv. The callback and all decoder state are bound to this call,
+   so different threads may stream maps at the same time, each one
+   with its own client.  */
+extern int yp_all_clnt (CLIENT *clnt, const char *indomain,
+			const char *inmap,
+			const struct ypall_callback *incallback);
+
 #endif /* __YP_ALL_HOST_H__ */
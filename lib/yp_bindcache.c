@@ -0,0 +1,181 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This library is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   in version 2.1 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <rpc/rpc.h>
+#include "internal.h"
+#include "yp_cachefile.h"
+
+/* Remember where ypserv on a host listens, so that setting a binding
+   to the same server again does not need a portmapper round trip and
+   a client first. ypserv gets a new port if it is restarted, so the
+   entries are only used for BINDING_TTL seconds. The file has one
+   line per host: "host netid uaddr time".  */
+#define BINDING_TTL (5 * 60)
+#define BINDING_FILE "bindings"
+#define BINDING_MAXID 32
+#define BINDING_MAXADDR 128
+#define BINDING_MAXHOST 256
+
+struct binding
+{
+  char *host;
+  char netid[BINDING_MAXID];
+  char uaddr[BINDING_MAXADDR];
+  time_t stamp;
+  struct binding *next;
+};
+
+static pthread_mutex_t binding_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct binding *binding_list;
+
+static void binding_parse (const char *line, time_t now);
+static void binding_format (FILE *fp, time_t now);
+
+static struct yp_cachefile binding_file =
+{
+  BINDING_FILE, binding_parse, binding_format, &binding_lock, 0, 0, 0, NULL
+};
+
+static struct binding *
+binding_find (const char *host)
+{
+  struct binding *e;
+
+  for (e = binding_list; e; e = e->next)
+    if (strcmp (e->host, host) == 0)
+      return e;
+  return NULL;
+}
+
+/* Add or replace an entry, the newer one wins.  */
+static void
+binding_add (const char *host, const char *netid, const char *uaddr,
+	     time_t stamp)
+{
+  struct binding *e = binding_find (host);
+
+  if (strlen (netid) >= BINDING_MAXID || strlen (uaddr) >= BINDING_MAXADDR)
+    return;
+
+  if (e == NULL)
+    {
+      e = calloc (1, sizeof (struct binding));
+      if (e == NULL || (e->host = strdup (host)) == NULL)
+	{
+	  free (e);
+	  return;
+	}
+      e->next = binding_list;
+      binding_list = e;
+    }
+  else if (e->stamp > stamp)
+    return;
+  strcpy (e->netid, netid);
+  strcpy (e->uaddr, uaddr);
+  e->stamp = stamp;
+}
+
+static void
+binding_parse (const char *line, time_t now)
+{
+  char host[1025], netid[BINDING_MAXID], uaddr[BINDING_MAXADDR];
+  long long stamp;
+
+  if (sscanf (line, "%1024s %31s %127s %lld", host, netid, uaddr,
+	      &stamp) == 4 && stamp <= now && now - stamp < BINDING_TTL)
+    binding_add (host, netid, uaddr, stamp);
+}
+
+static void
+binding_format (FILE *fp, time_t now)
+{
+  struct binding *e;
+
+  for (e = binding_list; e; e = e->next)
+    if (now - e->stamp < BINDING_TTL)
+      fprintf (fp, "%s %s %s %lld\n", e->host, e->netid, e->uaddr,
+	       (long long) e->stamp);
+}
+
+/* Called with binding_lock held.  */
+static struct binding *
+binding_get (const char *host)
+{
+  struct binding *e;
+
+  __yp_cachefile_load (&binding_file);
+  e = binding_find (host);
+  if (e == NULL || time (NULL) - e->stamp >= BINDING_TTL)
+    return NULL;
+  return e;
+}
+
+/* Look up the transport and universal address of ypserv on host.
+   Returns 0 and fills in netid and uaddr if a fresh entry exists,
+   -1 otherwise.  */
+int
+__yp_bindcache_get (const char *host, char *netid, size_t netidlen,
+		    char *uaddr, size_t uaddrlen)
+{
+  char buf[BINDING_MAXHOST];
+  struct binding *e;
+  int ret = -1;
+
+  if ((host = __yp_cache_host (host, buf, sizeof (buf))) == NULL)
+    return -1;
+
+  pthread_mutex_lock (&binding_lock);
+  e = binding_get (host);
+  if (e != NULL && strlen (e->netid) < netidlen &&
+      strlen (e->uaddr) < uaddrlen)
+    {
+      strcpy (netid, e->netid);
+      strcpy (uaddr, e->uaddr);
+      ret = 0;
+    }
+  pthread_mutex_unlock (&binding_lock);
+  return ret;
+}
+
+/* Remember that ypserv on host answers on uaddr with transport
+   netid. The file is written once at exit.  */
+void
+__yp_bindcache_set (const char *host, const char *netid, const char *uaddr)
+{
+  char buf[BINDING_MAXHOST];
+  struct binding *e;
+
+  if ((host = __yp_cache_host (host, buf, sizeof (buf))) == NULL)
+    return;
+
+  pthread_mutex_lock (&binding_lock);
+  e = binding_get (host);
+  if (e == NULL || strcmp (e->netid, netid) != 0 ||
+      strcmp (e->uaddr, uaddr) != 0)
+    {
+      binding_add (host, netid, uaddr, time (NULL));
+      __yp_cachefile_changed (&binding_file);
+    }
+  pthread_mutex_unlock (&binding_lock);
+}
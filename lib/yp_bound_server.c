@@ -0,0 +1,122 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This library is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   in version 2.1 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <rpc/rpc.h>
+#include <rpcsvc/ypclnt.h>
+#include <rpcsvc/yp_prot.h>
+#include "internal.h"
+
+#if !defined(HAVE_YPBIND3)
+#define ypbind2_resp ypbind_resp
+#endif
+
+/* Ask the local ypbind to which NIS server 'domain' is bound.
+   Returns the name or the address of the server in a malloc'ed
+   string. If ypbind cannot be reached, *err is set to YPERR_YPBIND,
+   if the domain is not bound to YPERR_DOMAIN.  */
+char *
+__yp_bound_server (const char *domain, int *err)
+{
+  int ret;
+  char *res = NULL;
+#if defined(HAVE_YPBIND3)
+  struct ypbind3_resp yp3_r;
+#endif
+
+  *err = YPERR_YPBIND;
+
+#if defined(HAVE_YPBIND3)
+  memset (&yp3_r, 0, sizeof (struct ypbind3_resp));
+
+  /* Don't try version 3 again if we know it fails */
+  if (__yp_rpcvers_get ("localhost", YPBINDPROG) == YPBINDVERS_2)
+    ret = RPC_PROGVERSMISMATCH;
+  else
+    {
+      ret = rpc_call ("localhost", YPBINDPROG, YPBINDVERS, YPBINDPROC_DOMAIN,
+		      (xdrproc_t) xdr_domainname, (caddr_t) &domain,
+		      (xdrproc_t) xdr_ypbind3_resp, (caddr_t) &yp3_r,
+		      "udp");
+      if (ret == RPC_PROGVERSMISMATCH)
+	__yp_rpcvers_set ("localhost", YPBINDPROG, YPBINDVERS_2);
+    }
+  if (ret == RPC_SUCCESS)
+    {
+      if (yp3_r.ypbind_status != YPBIND_SUCC_VAL)
+	*err = YPERR_DOMAIN;
+      else if (yp3_r.ypbind3_servername &&
+	       strlen (yp3_r.ypbind3_servername) > 0)
+	res = strdup (yp3_r.ypbind3_servername);
+      else if (yp3_r.ypbind3_nconf && yp3_r.ypbind3_svcaddr)
+	{
+	  char buf[INET6_ADDRSTRLEN];
+
+	  if (taddr2ipstr (yp3_r.ypbind3_nconf, yp3_r.ypbind3_svcaddr,
+			   buf, sizeof (buf)) != NULL)
+	    res = strdup (buf);
+	}
+      xdr_free ((xdrproc_t) xdr_ypbind3_resp, (char *) &yp3_r);
+    }
+  else if (ret == RPC_PROGVERSMISMATCH)
+#endif
+    {
+      /* Looks like ypbind does not support V3 yet, fallback
+	 to V2 */
+      struct ypbind2_resp yp2_r;
+
+      memset (&yp2_r, 0, sizeof (struct ypbind2_resp));
+
+#if defined (HAVE_YPBIND3)
+      ret = rpc_call ("localhost", YPBINDPROG, YPBINDVERS_2,
+		      YPBINDPROC_DOMAIN,
+		      (xdrproc_t) xdr_domainname, (caddr_t) &domain,
+		      (xdrproc_t) xdr_ypbind2_resp, (caddr_t) &yp2_r,
+		      "udp");
+#else
+      ret = callrpc ("localhost", YPBINDPROG, YPBINDVERS,
+		     YPBINDPROC_DOMAIN,
+		     (xdrproc_t) xdr_domainname, (caddr_t) &domain,
+		     (xdrproc_t) xdr_ypbind_resp, (caddr_t) &yp2_r);
+#endif
+      if (ret == RPC_SUCCESS)
+	{
+	  if (yp2_r.ypbind_status != YPBIND_SUCC_VAL)
+	    *err = YPERR_DOMAIN;
+	  else
+	    {
+	      char straddr[INET_ADDRSTRLEN];
+	      struct in_addr addr =
+		yp2_r.ypbind_respbody.ypbind_bindinfo.ypbind_binding_addr;
+
+	      if (inet_ntop (AF_INET, &addr, straddr,
+			     sizeof (straddr)) != NULL)
+		res = strdup (straddr);
+	    }
+	}
+    }
+
+  if (res != NULL)
+    *err = YPERR_SUCCESS;
+
+  return res;
+}
@@ -0,0 +1,221 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This library is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   in version 2.1 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <rpc/rpc.h>
+#include "internal.h"
+#include "yp_cachefile.h"
+
+/* Every process reads a cache file once. At exit, the changed files
+   are read again to merge the entries which other processes wrote in
+   the meantime, and are replaced. The files keep the mode 0600 of
+   mkstemp.  */
+
+static pthread_mutex_t cachefile_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct yp_cachefile *cachefile_list;
+
+/* $XDG_CACHE_HOME/yp-tools or ~/.cache/yp-tools, NULL if there is
+   no home directory.  */
+char *
+__yp_cache_dir (int create)
+{
+  const char *xdg = getenv ("XDG_CACHE_HOME");
+  const char *home = getenv ("HOME");
+  char *dir;
+
+  if (xdg != NULL && xdg[0] == '/')
+    {
+      if (asprintf (&dir, "%s/yp-tools", xdg) < 0)
+	return NULL;
+      if (create)
+	mkdir (xdg, 0700);
+    }
+  else if (home != NULL && home[0] == '/')
+    {
+      if (asprintf (&dir, "%s/.cache/yp-tools", home) < 0)
+	return NULL;
+      if (create)
+	{
+	  char *cache;
+
+	  if (asprintf (&cache, "%s/.cache", home) >= 0)
+	    {
+	      mkdir (cache, 0700);
+	      free (cache);
+	    }
+	}
+    }
+  else
+    return NULL;
+
+  if (create && mkdir (dir, 0700) != 0 && errno != EEXIST)
+    {
+      free (dir);
+      return NULL;
+    }
+  return dir;
+}
+
+/* The name under which entries for host are stored. The local
+   machine is stored under its own name, not as "localhost", so that
+   machines which share the home directory over NFS do not use the
+   entries of each other. Returns NULL if the name is unknown.  */
+const char *
+__yp_cache_host (const char *host, char *buf, size_t buflen)
+{
+  if (strcmp (host, "localhost") != 0 &&
+      strncmp (host, "localhost.", 10) != 0 &&
+      strncmp (host, "127.", 4) != 0 && strcmp (host, "::1") != 0)
+    return host;
+
+  if (buflen == 0 || gethostname (buf, buflen) != 0)
+    return NULL;
+  buf[buflen - 1] = '\0';
+  return buf[0] != '\0' ? buf : NULL;
+}
+
+static char *
+cachefile_path (const struct yp_cachefile *cf, int create)
+{
+  char *dir, *path;
+
+  if ((dir = __yp_cache_dir (create)) == NULL)
+    return NULL;
+  if (asprintf (&path, "%s/%s", dir, cf->name) < 0)
+    path = NULL;
+  free (dir);
+  return path;
+}
+
+static void
+cachefile_read (struct yp_cachefile *cf)
+{
+  char *path, *line = NULL;
+  size_t linesize = 0;
+  time_t now = time (NULL);
+  FILE *fp;
+
+  if ((path = cachefile_path (cf, 0)) == NULL)
+    return;
+  fp = fopen (path, "re");
+  free (path);
+  if (fp == NULL)
+    return;
+
+  while (getline (&line, &linesize, fp) > 0)
+    cf->parse (line, now);
+  free (line);
+  fclose (fp);
+}
+
+static void
+cachefile_write (struct yp_cachefile *cf)
+{
+  char *path, *tmppath;
+  FILE *fp;
+  int fd;
+
+  if (!cf->dirty)
+    return;
+  cf->dirty = 0;
+
+  cachefile_read (cf);
+
+  if ((path = cachefile_path (cf, 1)) == NULL)
+    return;
+  if (asprintf (&tmppath, "%s.XXXXXX", path) < 0)
+    {
+      free (path);
+      return;
+    }
+
+  fd = mkstemp (tmppath);
+  if (fd >= 0 && (fp = fdopen (fd, "w")) != NULL)
+    {
+      cf->format (fp, time (NULL));
+      if (fclose (fp) != 0 || rename (tmppath, path) != 0)
+	unlink (tmppath);
+    }
+  else if (fd >= 0)
+    {
+      close (fd);
+      unlink (tmppath);
+    }
+
+  free (tmppath);
+  free (path);
+}
+
+static void
+cachefile_atexit (void)
+{
+  struct yp_cachefile *cf;
+
+  /* Entries are only added at the head, so the list can be walked
+     without holding cachefile_lock, and __yp_cachefile_changed
+     takes it with the lock of a cache held.  */
+  pthread_mutex_lock (&cachefile_lock);
+  cf = cachefile_list;
+  pthread_mutex_unlock (&cachefile_lock);
+
+  for (; cf; cf = cf->next)
+    {
+      pthread_mutex_lock (cf->lock);
+      cachefile_write (cf);
+      pthread_mutex_unlock (cf->lock);
+    }
+}
+
+void
+__yp_cachefile_load (struct yp_cachefile *cf)
+{
+  if (!cf->loaded)
+    {
+      cf->loaded = 1;
+      cachefile_read (cf);
+    }
+}
+
+void
+__yp_cachefile_changed (struct yp_cachefile *cf)
+{
+  static int registered;
+
+  cf->dirty = 1;
+  if (cf->registered)
+    return;
+
+  pthread_mutex_lock (&cachefile_lock);
+  if (registered || atexit (cachefile_atexit) == 0)
+    {
+      registered = 1;
+      cf->next = cachefile_list;
+      cachefile_list = cf;
+      cf->registered = 1;
+    }
+  pthread_mutex_unlock (&cachefile_lock);
+}
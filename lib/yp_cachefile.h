@@ -0,0 +1,48 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This library is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   in version 2.1 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifndef __YP_CACHEFILE_H__
+#define __YP_CACHEFILE_H__
+
+#include <time.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* A small file in the cache directory with one entry per line, which
+   is shared by all processes of the user. The entries are kept by
+   the owner of the yp_cachefile, this only reads and writes the
+   file.  */
+struct yp_cachefile
+{
+  /* Name of the file in the cache directory */
+  const char *name;
+  /* Called for every line of the file, with lock held */
+  void (*parse) (const char *line, time_t now);
+  /* Write every entry which is still valid, with lock held */
+  void (*format) (FILE *fp, time_t now);
+  /* Protects the entries and the fields below */
+  pthread_mutex_t *lock;
+  int loaded;
+  int dirty;
+  int registered;
+  struct yp_cachefile *next;
+};
+
+/* Read the file, if this was not done before. Call with lock held.  */
+extern void __yp_cachefile_load (struct yp_cachefile *__cf);
+/* The entries changed, write them at exit. Call with lock held.  */
+extern void __yp_cachefile_changed (struct yp_cachefile *__cf);
+
+#endif /* __YP_CACHEFILE_H__ */
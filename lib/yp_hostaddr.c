@@ -0,0 +1,382 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <time.h>
+#include <errno.h>
+#include <netdb.h>
+#include <libintl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include "yp_hostaddr.h"
+
+#ifndef _
+#define _(String) gettext (String)
+#endif
+
+#define RESOLVE_THREADS 16
+/* A thread whose lookup takes too long is replaced, but it runs on
+   until getaddrinfo returns. Never start more threads than this.  */
+#define RESOLVE_MAXTHREADS (4 * RESOLVE_THREADS)
+
+struct resolve_result
+{
+  int started;
+  int finished;
+  /* The lookup took longer than the timeout, the caller gave up.  */
+  int expired;
+  struct timespec start;
+  int error;
+  struct sockaddr_in addr;
+  struct timeval elapsed;
+};
+
+/* Shared by the caller and the threads. The caller does not wait for
+   lookups which take longer than the timeout, so the threads work on
+   their own copy of the names and the last one frees the job.  */
+struct resolve_job
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int refs;
+  int abandoned;
+  size_t n;
+  size_t next;
+  size_t done;
+  /* Running threads, and those of them whose lookup did not expire */
+  size_t threads;
+  size_t live;
+  char **names;
+  struct resolve_result *res;
+};
+
+static void
+job_unref (struct resolve_job *job)
+{
+  size_t i;
+  int refs;
+
+  pthread_mutex_lock (&job->lock);
+  refs = --job->refs;
+  pthread_mutex_unlock (&job->lock);
+  if (refs > 0)
+    return;
+
+  for (i = 0; i < job->n; i++)
+    free (job->names[i]);
+  free (job->names);
+  free (job->res);
+  pthread_cond_destroy (&job->cond);
+  pthread_mutex_destroy (&job->lock);
+  free (job);
+}
+
+static void *
+resolve_thread (void *arg)
+{
+  struct resolve_job *job = arg;
+  int expired = 0;
+
+  pthread_mutex_lock (&job->lock);
+  while (!job->abandoned && job->next < job->n)
+    {
+      size_t i = job->next++;
+      struct resolve_result *r = &job->res[i];
+      struct addrinfo hints, *ai;
+      struct timespec start, end;
+      int err;
+
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      r->start = start;
+      r->started = 1;
+      /* The caller waits for the deadline of this lookup now.  */
+      pthread_cond_broadcast (&job->cond);
+      pthread_mutex_unlock (&job->lock);
+
+      memset (&hints, 0, sizeof (hints));
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_DGRAM;
+      err = getaddrinfo (job->names[i], NULL, &hints, &ai);
+      clock_gettime (CLOCK_MONOTONIC, &end);
+
+      pthread_mutex_lock (&job->lock);
+      if (r->expired)
+	{
+	  /* Another thread took over the rest of the queue.  */
+	  if (err == 0)
+	    freeaddrinfo (ai);
+	  expired = 1;
+	  break;
+	}
+      r->error = err;
+      if (err == 0)
+	{
+	  memcpy (&r->addr, ai->ai_addr, sizeof (struct sockaddr_in));
+	  freeaddrinfo (ai);
+	}
+      r->elapsed.tv_sec = end.tv_sec - start.tv_sec;
+      r->elapsed.tv_usec = (end.tv_nsec - start.tv_nsec) / 1000;
+      if (r->elapsed.tv_usec < 0)
+	{
+	  r->elapsed.tv_sec--;
+	  r->elapsed.tv_usec += 1000000;
+	}
+      r->finished = 1;
+      job->done++;
+      pthread_cond_broadcast (&job->cond);
+    }
+  if (!expired)
+    job->live--;
+  job->threads--;
+  pthread_cond_broadcast (&job->cond);
+  pthread_mutex_unlock (&job->lock);
+
+  job_unref (job);
+  return NULL;
+}
+
+static struct resolve_job *
+job_create (struct yp_hostaddr **hosts, size_t n)
+{
+  struct resolve_job *job = calloc (1, sizeof (struct resolve_job));
+  pthread_condattr_t attr;
+  size_t i;
+
+  if (job == NULL)
+    return NULL;
+  job->names = calloc (n, sizeof (char *));
+  job->res = calloc (n, sizeof (struct resolve_result));
+  if (job->names == NULL || job->res == NULL)
+    goto fail;
+  for (i = 0; i < n; i++)
+    if ((job->names[i] = strdup (hosts[i]->name)) == NULL)
+      goto fail;
+  job->n = n;
+  job->refs = 1;
+  pthread_mutex_init (&job->lock, NULL);
+  /* The deadlines are CLOCK_MONOTONIC, like the start times.  */
+  pthread_condattr_init (&attr);
+  pthread_condattr_setclock (&attr, CLOCK_MONOTONIC);
+  pthread_cond_init (&job->cond, &attr);
+  pthread_condattr_destroy (&attr);
+  return job;
+
+ fail:
+  if (job->names)
+    for (i = 0; i < n; i++)
+      free (job->names[i]);
+  free (job->names);
+  free (job->res);
+  free (job);
+  return NULL;
+}
+
+/* Start threads until RESOLVE_THREADS work on lookups which did not
+   expire, or every host in the queue has one. Called with the lock
+   held.  */
+static void
+job_spawn (struct resolve_job *job, pthread_attr_t *attr)
+{
+  while (job->live < RESOLVE_THREADS && job->live < job->n - job->next &&
+	 job->threads < RESOLVE_MAXTHREADS)
+    {
+      pthread_t tid;
+
+      job->refs++;
+      if (pthread_create (&tid, attr, resolve_thread, job) != 0)
+	{
+	  job->refs--;
+	  break;
+	}
+      job->threads++;
+      job->live++;
+    }
+}
+
+void
+yp_resolve_hosts (struct yp_hostaddr **hosts, size_t n,
+		  const struct timeval *timeout)
+{
+  struct resolve_job *job;
+  pthread_attr_t attr;
+  size_t i;
+
+  if (n == 0)
+    return;
+  if ((job = job_create (hosts, n)) == NULL)
+    {
+      for (i = 0; i < n; i++)
+	hosts[i]->error = EAI_MEMORY;
+      return;
+    }
+
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+  pthread_mutex_lock (&job->lock);
+  job_spawn (job, &attr);
+
+  /* Without a thread, do the lookups here.  */
+  if (job->threads == 0)
+    {
+      job->refs++;
+      job->threads++;
+      job->live++;
+      pthread_mutex_unlock (&job->lock);
+      resolve_thread (job);
+      pthread_mutex_lock (&job->lock);
+    }
+
+  /* Every host has the whole timeout, counted from the start of its
+     own lookup, not from the start of all lookups. A host which is
+     still in the queue has not used any of it.  */
+  while (job->done < job->n)
+    {
+      struct timespec now, wake;
+      int have_wake = 0;
+
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      for (i = 0; i < n; i++)
+	{
+	  struct resolve_result *r = &job->res[i];
+	  struct timespec deadline;
+
+	  if (!r->started || r->finished || r->expired)
+	    continue;
+	  deadline.tv_sec = r->start.tv_sec + timeout->tv_sec;
+	  deadline.tv_nsec = r->start.tv_nsec + timeout->tv_usec * 1000;
+	  if (deadline.tv_nsec >= 1000000000)
+	    {
+	      deadline.tv_sec++;
+	      deadline.tv_nsec -= 1000000000;
+	    }
+	  if (now.tv_sec > deadline.tv_sec ||
+	      (now.tv_sec == deadline.tv_sec &&
+	       now.tv_nsec >= deadline.tv_nsec))
+	    {
+	      r->expired = 1;
+	      job->done++;
+	      job->live--;
+	    }
+	  else if (!have_wake || deadline.tv_sec < wake.tv_sec ||
+		   (deadline.tv_sec == wake.tv_sec &&
+		    deadline.tv_nsec < wake.tv_nsec))
+	    {
+	      wake = deadline;
+	      have_wake = 1;
+	    }
+	}
+      if (job->done >= job->n)
+	break;
+
+      /* Replace the threads which hang in an expired lookup.  */
+      job_spawn (job, &attr);
+      if (job->threads == 0)
+	break;
+      if (have_wake)
+	pthread_cond_timedwait (&job->cond, &job->lock, &wake);
+      else
+	pthread_cond_wait (&job->cond, &job->lock);
+    }
+  job->abandoned = 1;
+  pthread_attr_destroy (&attr);
+
+  for (i = 0; i < n; i++)
+    {
+      struct yp_hostaddr *h = hosts[i];
+      struct resolve_result *r = &job->res[i];
+
+      if (!r->finished)
+	{
+	  /* Not even started if no thread could be created.  */
+	  h->error = EAI_AGAIN;
+	  h->timedout = r->expired;
+	  if (r->expired)
+	    h->elapsed = *timeout;
+	  else
+	    timerclear (&h->elapsed);
+	  continue;
+	}
+      h->error = r->error;
+      h->timedout = 0;
+      h->elapsed = r->elapsed;
+      if (r->error == 0)
+	{
+	  memset (&h->addr, 0, sizeof (h->addr));
+	  memcpy (&h->addr, &r->addr, sizeof (struct sockaddr_in));
+	  h->addrlen = sizeof (struct sockaddr_in);
+	}
+    }
+  pthread_mutex_unlock (&job->lock);
+
+  job_unref (job);
+}
+
+const char *
+yp_hostaddr_error (const struct yp_hostaddr *h)
+{
+  if (h->timedout)
+    return _("Timeout while looking up the host");
+  if (h->error == EAI_NONAME)
+    return _("Unknown host");
+  return gai_strerror (h->error);
+}
+
+int
+yp_hostaddr_left (const struct yp_hostaddr *h, const struct timeval *timeout,
+		  struct timeval *left)
+{
+  if (!timercmp (&h->elapsed, timeout, <))
+    {
+      timerclear (left);
+      return 0;
+    }
+  timersub (timeout, &h->elapsed, left);
+  return 1;
+}
+
+void
+yp_hostaddr_setport (struct yp_hostaddr *h, u_short port)
+{
+  ((struct sockaddr_in *) &h->addr)->sin_port = htons (port);
+}
+
+void
+yp_hostaddr_getport (struct yp_hostaddr *h, u_long prog, u_long vers,
+		     struct rpcpipe_call *call)
+{
+  yp_hostaddr_setport (h, PMAPPORT);
+  h->pmap.pm_prog = prog;
+  h->pmap.pm_vers = vers;
+  h->pmap.pm_prot = IPPROTO_UDP;
+  h->pmap.pm_port = 0;
+  h->port = 0;
+
+  call->addr = (struct sockaddr *) &h->addr;
+  call->addrlen = h->addrlen;
+  call->prog = PMAPPROG;
+  call->vers = PMAPVERS;
+  call->proc = PMAPPROC_GETPORT;
+  call->inproc = (xdrproc_t) xdr_pmap;
+  call->in = (caddr_t) &h->pmap;
+  call->outproc = (xdrproc_t) xdr_u_long;
+  call->out = (caddr_t) &h->port;
+}
@@ -0,0 +1,65 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifndef __YP_HOSTADDR_H__
+#define __YP_HOSTADDR_H__
+
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <rpc/rpc.h>
+#include <rpc/pmap_prot.h>
+#include "rpcpipe.h"
+
+/* A host whose portmapper is asked for a port with rpcpipe. Only
+   IPv4 addresses are used, because the portmapper answers version 2
+   calls only over IPv4.  */
+struct yp_hostaddr
+{
+  const char *name;
+  struct sockaddr_storage addr;
+  socklen_t addrlen;
+  /* 0 or the error of getaddrinfo, EAI_AGAIN and timedout set if
+     the lookup did not finish in time.  */
+  int error;
+  int timedout;
+  /* The time the lookup took, it counts against the timeout of the
+     calls to this host.  */
+  struct timeval elapsed;
+  struct pmap pmap;
+  u_long port;
+};
+
+/* Look up all hosts in parallel, before the calls are started, so
+   that a slow DNS server does not stop the calls in flight. Every
+   lookup may take up to timeout from its own start, a host which
+   waits for a free thread does not lose any of it.  */
+extern void yp_resolve_hosts (struct yp_hostaddr **hosts, size_t n,
+			      const struct timeval *timeout);
+/* Why the host could not be looked up.  */
+extern const char *yp_hostaddr_error (const struct yp_hostaddr *h);
+/* Store in left the time of timeout which the lookup did not use.
+   Returns 0 if nothing is left.  */
+extern int yp_hostaddr_left (const struct yp_hostaddr *h,
+			      const struct timeval *timeout,
+			      struct timeval *left);
+extern void yp_hostaddr_setport (struct yp_hostaddr *h, u_short port);
+/* Fill in call to ask the portmapper of h for the UDP port of
+   prog/vers, the answer is stored in h->port.  */
+extern void yp_hostaddr_getport (struct yp_hostaddr *h, u_long prog,
+				 u_long vers, struct rpcpipe_call *call);
+
+#endif /* __YP_HOSTADDR_H__ */
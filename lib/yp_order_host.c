@@ -0,0 +1,69 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <rpc/rpc.h>
+#include <rpcsvc/ypclnt.h>
+#include <rpcsvc/yp_prot.h>
+#include "yp_order_host.h"
+
+static struct timeval RPCTIMEOUT = {10, 0};
+
+/* Like yp_order, but ask ypserv on hostname. This is a single
+   UDP round trip, much cheaper than fetching the map.  */
+int
+yp_order_host (const char *indomain, const char *inmap,
+	       unsigned int *outorder, const char *hostname)
+{
+  struct ypreq_nokey req;
+  struct ypresp_order resp;
+  enum clnt_stat result;
+  CLIENT *clnt;
+  int res;
+
+  if (hostname == NULL || hostname[0] == '\0' ||
+      indomain == NULL || indomain[0] == '\0' ||
+      inmap == NULL || inmap[0] == '\0')
+    return YPERR_BADARGS;
+
+  clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
+  if (clnt == NULL)
+    return YPERR_PMAP;
+
+  req.domain = (char *) indomain;
+  req.map = (char *) inmap;
+  memset (&resp, '\0', sizeof (resp));
+
+  result = clnt_call (clnt, YPPROC_ORDER, (xdrproc_t) xdr_ypreq_nokey,
+		      (caddr_t) &req, (xdrproc_t) xdr_ypresp_order,
+		      (caddr_t) &resp, RPCTIMEOUT);
+  clnt_destroy (clnt);
+
+  if (result != RPC_SUCCESS)
+    return YPERR_RPC;
+
+  res = ypprot_err (resp.status);
+  if (res == YPERR_SUCCESS)
+    *outorder = resp.ordernum;
+  xdr_free ((xdrproc_t) xdr_ypresp_order, (char *) &resp);
+
+  return res;
+}
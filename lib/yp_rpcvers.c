@@ -0,0 +1,162 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This library is free software: you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public License
+   in version 2.1 as published by the Free Software Foundation.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>. */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <rpc/rpc.h>
+#include "internal.h"
+#include "yp_cachefile.h"
+
+/* Remember for one day which version of a RPC program a host
+   speaks, so that the tools do not have to find it out with a
+   failing call every time. The file has one line per host and
+   program: "host program version time".  */
+#define RPCVERS_TTL (24 * 60 * 60)
+#define RPCVERS_FILE "rpcvers"
+#define CACHE_MAXHOST 256
+
+struct rpcvers
+{
+  char *host;
+  u_long prog;
+  u_long vers;
+  time_t stamp;
+  struct rpcvers *next;
+};
+
+static pthread_mutex_t rpcvers_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct rpcvers *rpcvers_list;
+
+static void rpcvers_parse (const char *line, time_t now);
+static void rpcvers_format (FILE *fp, time_t now);
+
+static struct yp_cachefile rpcvers_file =
+{
+  RPCVERS_FILE, rpcvers_parse, rpcvers_format, &rpcvers_lock, 0, 0, 0, NULL
+};
+
+static struct rpcvers *
+rpcvers_find (const char *host, u_long prog)
+{
+  struct rpcvers *e;
+
+  for (e = rpcvers_list; e; e = e->next)
+    if (e->prog == prog && strcmp (e->host, host) == 0)
+      return e;
+  return NULL;
+}
+
+/* Add or replace an entry, the newer one wins.  */
+static void
+rpcvers_add (const char *host, u_long prog, u_long vers, time_t stamp)
+{
+  struct rpcvers *e = rpcvers_find (host, prog);
+
+  if (e == NULL)
+    {
+      e = calloc (1, sizeof (struct rpcvers));
+      if (e == NULL || (e->host = strdup (host)) == NULL)
+	{
+	  free (e);
+	  return;
+	}
+      e->prog = prog;
+      e->next = rpcvers_list;
+      rpcvers_list = e;
+    }
+  else if (e->stamp > stamp)
+    return;
+  e->vers = vers;
+  e->stamp = stamp;
+}
+
+static void
+rpcvers_parse (const char *line, time_t now)
+{
+  char host[1025];
+  unsigned long prog, vers;
+  long long stamp;
+
+  if (sscanf (line, "%1024s %lu %lu %lld", host, &prog, &vers,
+	      &stamp) == 4 && stamp <= now && now - stamp < RPCVERS_TTL)
+    rpcvers_add (host, prog, vers, stamp);
+}
+
+static void
+rpcvers_format (FILE *fp, time_t now)
+{
+  struct rpcvers *e;
+
+  for (e = rpcvers_list; e; e = e->next)
+    if (now - e->stamp < RPCVERS_TTL)
+      fprintf (fp, "%s %lu %lu %lld\n", e->host, (unsigned long) e->prog,
+	       (unsigned long) e->vers, (long long) e->stamp);
+}
+
+/* Called with rpcvers_lock held.  */
+static u_long
+rpcvers_get (const char *host, u_long prog)
+{
+  struct rpcvers *e;
+
+  __yp_cachefile_load (&rpcvers_file);
+  e = rpcvers_find (host, prog);
+  if (e == NULL || time (NULL) - e->stamp >= RPCVERS_TTL)
+    return 0;
+  return e->vers;
+}
+
+/* Returns the version of program prog which worked with host during
+   the last day, or 0 if we do not know it.  */
+u_long
+__yp_rpcvers_get (const char *host, u_long prog)
+{
+  char buf[CACHE_MAXHOST];
+  u_long vers;
+
+  if ((host = __yp_cache_host (host, buf, sizeof (buf))) == NULL)
+    return 0;
+
+  pthread_mutex_lock (&rpcvers_lock);
+  vers = rpcvers_get (host, prog);
+  pthread_mutex_unlock (&rpcvers_lock);
+  return vers;
+}
+
+/* Remember that host speaks version vers of program prog. The file
+   is written once at exit.  */
+void
+__yp_rpcvers_set (const char *host, u_long prog, u_long vers)
+{
+  char buf[CACHE_MAXHOST];
+
+  if ((host = __yp_cache_host (host, buf, sizeof (buf))) == NULL)
+    return;
+
+  pthread_mutex_lock (&rpcvers_lock);
+  if (rpcvers_get (host, prog) != vers)
+    {
+      rpcvers_add (host, prog, vers, time (NULL));
+      __yp_cachefile_changed (&rpcvers_file);
+    }
+  pthread_mutex_unlock (&rpcvers_lock);
+}
@@ -0,0 +1,392 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <rpc/rpc.h>
+#include <rpcsvc/ypclnt.h>
+#include <rpcsvc/yp_prot.h>
+#include "ypsnap.h"
+
+#define YPSNAP_MAGIC "YPSNAP1"
+
+/* The file is the header followed by the records. Every record is
+   keylen, vallen, the key, a NUL byte, the value, a NUL byte, both
+   padded with RNDUP to a multiple of 4 bytes. So the mmap'ed file
+   can be handed to the ypall_callback functions without copying
+   anything.  */
+struct ypsnap_header
+{
+  char magic[8];
+  uint32_t order;
+  uint32_t count;
+  uint64_t size;
+};
+
+struct ypsnap_record
+{
+  uint32_t keylen;
+  uint32_t vallen;
+};
+
+static int
+valid_name (const char *name)
+{
+  return name != NULL && name[0] != '\0' && name[0] != '.' &&
+    strchr (name, '/') == NULL;
+}
+
+char *
+ypsnap_path (const char *cachedir, const char *domain,
+	     const char *server, const char *map)
+{
+  char *path;
+
+  if (!valid_name (domain) || !valid_name (server) || !valid_name (map))
+    return NULL;
+
+  if (asprintf (&path, "%s/%s", cachedir, domain) < 0)
+    return NULL;
+  if (mkdir (path, 0700) != 0 && errno != EEXIST)
+    {
+      free (path);
+      return NULL;
+    }
+  free (path);
+
+  if (asprintf (&path, "%s/%s/%s", cachedir, domain, server) < 0)
+    return NULL;
+  if (mkdir (path, 0700) != 0 && errno != EEXIST)
+    {
+      free (path);
+      return NULL;
+    }
+  free (path);
+
+  if (asprintf (&path, "%s/%s/%s/%s", cachedir, domain, server, map) < 0)
+    return NULL;
+
+  return path;
+}
+
+int
+ypsnap_foreach (const char *path, unsigned int order,
+		const struct ypall_callback *callback)
+{
+  const struct ypsnap_header *hdr;
+  struct stat st;
+  char *base, *p, *end;
+  uint32_t i;
+  int fd, ret = -1;
+
+  fd = open (path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+
+  if (fstat (fd, &st) != 0 ||
+      (size_t) st.st_size < sizeof (struct ypsnap_header))
+    {
+      close (fd);
+      return -1;
+    }
+
+  /* Private writable mapping: the callbacks get "char *" and
+     must not be able to modify the file.  */
+  base = mmap (NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	       fd, 0);
+  close (fd);
+  if (base == MAP_FAILED)
+    return -1;
+
+  hdr = (const struct ypsnap_header *) base;
+  if (memcmp (hdr->magic, YPSNAP_MAGIC, sizeof (hdr->magic)) != 0 ||
+      hdr->order != order ||
+      hdr->size != (uint64_t) st.st_size - sizeof (struct ypsnap_header))
+    goto out;
+
+  madvise (base, st.st_size, MADV_SEQUENTIAL);
+
+  /* Check the whole file before the first record is printed.  */
+  p = base + sizeof (struct ypsnap_header);
+  end = base + st.st_size;
+  for (i = 0; i < hdr->count; i++)
+    {
+      struct ypsnap_record *r = (struct ypsnap_record *) p;
+
+      if ((size_t) (end - p) < sizeof (struct ypsnap_record) ||
+	  r->keylen > YPMAXRECORD || r->vallen > YPMAXRECORD)
+	goto out;
+      p += sizeof (struct ypsnap_record) + RNDUP (r->keylen + 1) +
+	RNDUP (r->vallen + 1);
+      if (p > end)
+	goto out;
+    }
+  if (p != end)
+    goto out;
+
+  p = base + sizeof (struct ypsnap_header);
+  for (i = 0; i < hdr->count; i++)
+    {
+      struct ypsnap_record *r = (struct ypsnap_record *) p;
+      char *key = p + sizeof (struct ypsnap_record);
+      char *val = key + RNDUP (r->keylen + 1);
+
+      p = val + RNDUP (r->vallen + 1);
+      if ((*callback->foreach) (YP_TRUE, key, r->keylen, val, r->vallen,
+				callback->data))
+	break;
+    }
+  ret = 0;
+
+ out:
+  munmap (base, st.st_size);
+  return ret;
+}
+
+long
+ypsnap_count (const char *path)
+{
+  struct ypsnap_header hdr;
+  ssize_t n;
+  int fd;
+
+  fd = open (path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  n = read (fd, &hdr, sizeof (hdr));
+  close (fd);
+
+  if (n != sizeof (hdr) ||
+      memcmp (hdr.magic, YPSNAP_MAGIC, sizeof (hdr.magic)) != 0)
+    return -1;
+  return hdr.count;
+}
+
+int
+ypsnap_open (struct ypsnap_writer *w, const char *path)
+{
+  struct ypsnap_header hdr;
+  int fd;
+
+  memset (w, 0, sizeof (struct ypsnap_writer));
+
+  if (asprintf (&w->tmppath, "%s.XXXXXX", path) < 0)
+    {
+      w->tmppath = NULL;
+      return -1;
+    }
+  /* Keep the mode 0600 of mkstemp, the map may be shadow.byname.  */
+  fd = mkstemp (w->tmppath);
+  if (fd < 0 || (w->fp = fdopen (fd, "w")) == NULL)
+    {
+      if (fd >= 0)
+	{
+	  close (fd);
+	  unlink (w->tmppath);
+	}
+      free (w->tmppath);
+      w->tmppath = NULL;
+      return -1;
+    }
+  setvbuf (w->fp, NULL, _IOFBF, 64 * 1024);
+  w->path = strdup (path);
+
+  /* Written again with the real values by ypsnap_commit.  */
+  memset (&hdr, 0, sizeof (hdr));
+  if (w->path == NULL || fwrite (&hdr, sizeof (hdr), 1, w->fp) != 1)
+    {
+      ypsnap_abort (w);
+      return -1;
+    }
+
+  return 0;
+}
+
+void
+ypsnap_add (struct ypsnap_writer *w, const char *key, int keylen,
+	    const char *val, int vallen)
+{
+  static const char zero[4];
+  struct ypsnap_record r;
+  size_t keypad, valpad;
+
+  if (w->failed)
+    return;
+
+  r.keylen = keylen;
+  r.vallen = vallen;
+  keypad = RNDUP (keylen + 1) - keylen;
+  valpad = RNDUP (vallen + 1) - vallen;
+  if (fwrite (&r, sizeof (r), 1, w->fp) != 1 ||
+      fwrite (key, 1, keylen, w->fp) != (size_t) keylen ||
+      fwrite (zero, 1, keypad, w->fp) != keypad ||
+      fwrite (val, 1, vallen, w->fp) != (size_t) vallen ||
+      fwrite (zero, 1, valpad, w->fp) != valpad)
+    {
+      w->failed = 1;
+      return;
+    }
+
+  w->count++;
+  w->size += sizeof (r) + RNDUP (keylen + 1) + RNDUP (vallen + 1);
+}
+
+int
+ypsnap_commit (struct ypsnap_writer *w, unsigned int order)
+{
+  struct ypsnap_header hdr;
+
+  if (w->failed)
+    {
+      ypsnap_abort (w);
+      return -1;
+    }
+
+  memset (&hdr, 0, sizeof (hdr));
+  memcpy (hdr.magic, YPSNAP_MAGIC, sizeof (hdr.magic));
+  hdr.order = order;
+  hdr.count = w->count;
+  hdr.size = w->size;
+
+  if (fseek (w->fp, 0, SEEK_SET) != 0 ||
+      fwrite (&hdr, sizeof (hdr), 1, w->fp) != 1)
+    {
+      ypsnap_abort (w);
+      return -1;
+    }
+  if (fclose (w->fp) != 0)
+    {
+      w->fp = NULL;
+      ypsnap_abort (w);
+      return -1;
+    }
+  w->fp = NULL;
+
+  if (rename (w->tmppath, w->path) != 0)
+    {
+      ypsnap_abort (w);
+      return -1;
+    }
+
+  free (w->tmppath);
+  free (w->path);
+  w->tmppath = w->path = NULL;
+
+  return 0;
+}
+
+void
+ypsnap_abort (struct ypsnap_writer *w)
+{
+  if (w->fp)
+    fclose (w->fp);
+  if (w->tmppath)
+    unlink (w->tmppath);
+  free (w->tmppath);
+  free (w->path);
+  w->fp = NULL;
+  w->tmppath = w->path = NULL;
+}
+
+/* The map names cannot start with a dot, so ".<map>.keymode"
+   does not collide with a snapshot.  */
+static char *
+keymode_path (const char *path)
+{
+  const char *base = strrchr (path, '/');
+  char *kpath;
+
+  base = base ? base + 1 : path;
+  if (asprintf (&kpath, "%.*s.%s.keymode", (int) (base - path), path,
+		base) < 0)
+    return NULL;
+  return kpath;
+}
+
+enum ypsnap_keymode
+ypsnap_keymode_load (const char *path, unsigned int order)
+{
+  enum ypsnap_keymode mode = YPSNAP_KEYS_UNKNOWN;
+  unsigned int file_order;
+  char *kpath, buf[16];
+  FILE *fp;
+
+  if ((kpath = keymode_path (path)) == NULL)
+    return YPSNAP_KEYS_UNKNOWN;
+  fp = fopen (kpath, "re");
+  free (kpath);
+  if (fp == NULL)
+    return YPSNAP_KEYS_UNKNOWN;
+
+  if (fscanf (fp, "%u %15s", &file_order, buf) == 2 && file_order == order)
+    {
+      if (strcmp (buf, "plain") == 0)
+	mode = YPSNAP_KEYS_PLAIN;
+      else if (strcmp (buf, "nul") == 0)
+	mode = YPSNAP_KEYS_NUL;
+    }
+  fclose (fp);
+
+  return mode;
+}
+
+int
+ypsnap_keymode_save (const char *path, unsigned int order,
+		     enum ypsnap_keymode mode)
+{
+  char *kpath, *tmppath;
+  FILE *fp;
+  int fd, ret = -1;
+
+  if (mode == YPSNAP_KEYS_UNKNOWN || (kpath = keymode_path (path)) == NULL)
+    return -1;
+  if (asprintf (&tmppath, "%s.XXXXXX", kpath) < 0)
+    {
+      free (kpath);
+      return -1;
+    }
+
+  fd = mkstemp (tmppath);
+  if (fd >= 0 && (fp = fdopen (fd, "w")) != NULL)
+    {
+      fprintf (fp, "%u %s\n", order,
+	       mode == YPSNAP_KEYS_NUL ? "nul" : "plain");
+      if (fclose (fp) == 0 && rename (tmppath, kpath) == 0)
+	ret = 0;
+      else
+	unlink (tmppath);
+    }
+  else if (fd >= 0)
+    {
+      close (fd);
+      unlink (tmppath);
+    }
+
+  free (tmppath);
+  free (kpath);
+  return ret;
+}
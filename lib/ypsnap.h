@@ -0,0 +1,75 @@
+/* Copyright (C) 2026 Thorsten Kukuk
+   This file is part of the yp-tools.
+   Author: Thorsten Kukuk <kukuk@suse.de>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License version 2 as
+   published by the Free Software Foundation.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.  */
+
+#ifndef __YPSNAP_H__
+#define __YPSNAP_H__
+
+#include <stdio.h>
+
+/* Local snapshot of a NIS map, stored in
+   <cachedir>/<domain>/<server>/<map>. The file is only valid for
+   the order number it was written with.  */
+
+/* Collects the records of a map while it is streamed.  */
+struct ypsnap_writer
+{
+  FILE *fp;
+  char *path;
+  char *tmppath;
+  unsigned int count;
+  unsigned long long size;
+  int failed;
+};
+
+/* Returns the malloc'ed path of the snapshot and creates the
+   directories, or NULL if a name cannot be used as file name.  */
+extern char *ypsnap_path (const char *cachedir, const char *domain,
+			  const char *server, const char *map);
+
+/* Call the callback for every record of the snapshot, if it exists
+   and was written for order. Returns 0 if the snapshot was used, -1
+   otherwise.  */
+extern int ypsnap_foreach (const char *path, unsigned int order,
+			   const struct ypall_callback *callback);
+
+/* Number of records in the snapshot, even if it was written for
+   another order number, or -1 if there is none.  */
+extern long ypsnap_count (const char *path);
+
+extern int ypsnap_open (struct ypsnap_writer *w, const char *path);
+extern void ypsnap_add (struct ypsnap_writer *w, const char *key,
+			int keylen, const char *val, int vallen);
+/* Replace the old snapshot if all records were written.  */
+extern int ypsnap_commit (struct ypsnap_writer *w, unsigned int order);
+extern void ypsnap_abort (struct ypsnap_writer *w);
+
+/* Some maps store the keys with a trailing NUL byte. This is
+   remembered in a small file beside the snapshot, again only
+   valid for one order number.  */
+enum ypsnap_keymode
+{
+  YPSNAP_KEYS_UNKNOWN = -1,
+  YPSNAP_KEYS_PLAIN = 0,
+  YPSNAP_KEYS_NUL = 1
+};
+
+extern enum ypsnap_keymode ypsnap_keymode_load (const char *path,
+						unsigned int order);
+extern int ypsnap_keymode_save (const char *path, unsigned int order,
+				enum ypsnap_keymode mode);
+
+#endif /* __YPSNAP_H__ */
@@ -20,14 +20,25 @@
 #include "config.h"
 #endif
 
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
 #include <locale.h>
 #include <libintl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <rpcsvc/ypclnt.h>
 #include <rpcsvc/yp_prot.h>
 #include "lib/nicknames.h"
 #include "lib/yp_all_host.h"
+#include "lib/outbuf.h"
+#include "lib/internal.h"
+#include "lib/yp_order_host.h"
+#include "lib/ypsnap.h"
 
 #ifndef _
 #define _(String) gettext (String)
@@ -50,7 +61,8 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: ypcat [-kt] [-d domain] [-h hostname] mapname | -x\n"),
+  fputs (_("Usage: ypcat [-kt] [-d domain] [-h hostname] [-j jobs] [-o dir]\n"
+	   "             [--cache dir] [--stats] mapname ... | -a | -x\n"),
 	 stream);
 }
 
@@ -60,15 +72,25 @@ print_help (void)
   print_usage (stdout);
   fputs (_("ypcat - print values of all keys in a NIS database\n\n"), stdout);
 
+  fputs (_("  -a, --all      Print all maps of the domain\n"), stdout);
   fputs (_("  -d domain      Use 'domain' instead of the default domain\n"),
 	 stdout);
   fputs (_("  -h hostname    Query ypserv on 'hostname' instead the current one\n"),
 	 stdout);
+  fputs (_("  -j jobs        Stream up to 'jobs' maps at the same time\n"),
+	 stdout);
   fputs (_("  -k             Display map keys\n"),
 	 stdout);
+  fputs (_("  -o dir         Write every map into a file in 'dir'\n"),
+	 stdout);
   fputs (_("  -t             Inhibits map nickname translation\n"), stdout);
   fputs (_("  -x             Display the map nickname translation table\n"),
 	 stdout);
+  fputs (_("      --cache dir  Keep a snapshot of the maps in 'dir' and\n"
+	   "                 use it until the order number changes\n"),
+	 stdout);
+  fputs (_("      --stats    Print number of records and bytes per second\n"),
+	 stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -84,39 +106,215 @@ print_error (void)
 	   program, program);
 }
 
+#define DEFAULT_JOBS 4
+
 static int kflag = 0;
 
+/* One map to dump.  */
+struct dump_job
+{
+  const char *map;
+  struct outbuf output;
+  int output_errno;
+  int res;
+  /* Copy of the map for the cache, written while streaming */
+  struct ypsnap_writer snap;
+  int snapping;
+};
+
 static int
 print_data (int status, char *inkey, int inkeylen, char *inval,
-	    int invallen, char *indata __attribute__ ((unused)))
+	    int invallen, char *indata)
 {
+  struct dump_job *job = (struct dump_job *) indata;
+  const char *key = NULL;
+
   if (status != YP_TRUE)
     return status;
 
+  if (job->snapping)
+    ypsnap_add (&job->snap, inkey, inkeylen, inval, invallen);
+
   if (kflag  && (inkeylen > 0))
     {
       if (inkey[inkeylen - 1] == '\0')
 	--inkeylen;
-      fprintf (stdout, "%*.*s ", inkeylen, inkeylen, inkey);
+      key = inkey;
     }
   if (invallen > 0)
     {
       if (inval[invallen -1] == '\0')
 	--invallen;
-      fprintf (stdout, "%*.*s\n", invallen, invallen, inval);
     }
   else
-    fputs ("\n", stdout);
+    invallen = 0;
+
+  if (outbuf_put (&job->output, key, inkeylen, inval, invallen) != 0)
+    {
+      /* No need to fetch the rest of the map */
+      job->output_errno = errno;
+      return 1;
+    }
 
   return 0;
 }
 
+static const char *dump_domain;
+static const char *dump_host;
+static const char *dump_dir;
+static const char *dump_cache;
+static struct dump_job *dump_jobs;
+static size_t dump_njobs;
+static size_t dump_next;
+static pthread_mutex_t dump_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t stdout_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Stream one map. If dump_host is NULL, ask the server ypbind is
+   bound to, else dump_host. The output goes into a file in dump_dir,
+   or, if several maps are written to stdout, every line gets the
+   map name as prefix. With dump_cache, the map is printed from the
+   local snapshot if the order number did not change since it was
+   written, else the snapshot is replaced while streaming.  */
+static void
+dump_map (struct dump_job *job)
+{
+  struct ypall_callback ypcb;
+  unsigned int order = 0;
+  int fd = STDOUT_FILENO;
+
+  if (dump_dir)
+    {
+      char *path;
+
+      if (asprintf (&path, "%s/%s", dump_dir, job->map) < 0)
+	{
+	  job->output_errno = errno;
+	  return;
+	}
+      fd = open (path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      free (path);
+      if (fd < 0)
+	{
+	  job->output_errno = errno;
+	  return;
+	}
+    }
+
+  if (outbuf_init (&job->output, fd, OUTBUF_SIZE) != 0)
+    {
+      job->output_errno = errno;
+      if (dump_dir)
+	close (fd);
+      return;
+    }
+  if (!dump_dir && dump_njobs > 1)
+    {
+      job->output.prefix = job->map;
+      job->output.prefixlen = strlen (job->map);
+      job->output.lock = &stdout_lock;
+    }
+
+  ypcb.foreach = print_data;
+  ypcb.data = (char *) job;
+
+  if (dump_cache && yp_order_host (dump_domain, job->map, &order,
+				   dump_host) == YPERR_SUCCESS)
+    {
+      char *path = ypsnap_path (dump_cache, dump_domain, dump_host, job->map);
+
+      if (path != NULL)
+	{
+	  if (ypsnap_foreach (path, order, &ypcb) == 0)
+	    {
+	      free (path);
+	      job->res = YPERR_SUCCESS;
+	      goto done;
+	    }
+	  if (ypsnap_open (&job->snap, path) == 0)
+	    job->snapping = 1;
+	  free (path);
+	}
+    }
+
+  if (dump_host)
+    job->res = yp_all_host (dump_domain, job->map, &ypcb, dump_host);
+  else
+    job->res = yp_all (dump_domain, job->map, &ypcb);
+
+  if (job->snapping)
+    {
+      if (job->res == YPERR_SUCCESS && job->output_errno == 0)
+	ypsnap_commit (&job->snap, order);
+      else
+	ypsnap_abort (&job->snap);
+      job->snapping = 0;
+    }
+
+ done:
+  if (job->output_errno == 0 && outbuf_flush (&job->output) != 0)
+    job->output_errno = errno;
+  outbuf_destroy (&job->output);
+
+  if (dump_dir && close (fd) != 0 && job->output_errno == 0)
+    job->output_errno = errno;
+}
+
+static void *
+dump_worker (void *arg __attribute__ ((unused)))
+{
+  while (1)
+    {
+      size_t i;
+
+      pthread_mutex_lock (&dump_lock);
+      i = dump_next++;
+      pthread_mutex_unlock (&dump_lock);
+
+      if (i >= dump_njobs)
+	break;
+      dump_map (&dump_jobs[i]);
+    }
+  return NULL;
+}
+
+/* Ask ypserv on hostname for all maps of the domain.  */
+static int
+get_maplist (const char *domain, const char *hostname,
+	     struct ypmaplist **list)
+{
+  static struct timeval RPCTIMEOUT = {25, 0};
+  struct ypresp_maplist resp;
+  enum clnt_stat result;
+  CLIENT *clnt;
+
+  clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
+  if (clnt == NULL)
+    return YPERR_PMAP;
+
+  memset (&resp, 0, sizeof (resp));
+  result = clnt_call (clnt, YPPROC_MAPLIST, (xdrproc_t) xdr_domainname,
+		      (caddr_t) &domain, (xdrproc_t) xdr_ypresp_maplist,
+		      (caddr_t) &resp, RPCTIMEOUT);
+  clnt_destroy (clnt);
+
+  if (result != RPC_SUCCESS)
+    return YPERR_RPC;
+  if (resp.status != YP_TRUE)
+    return ypprot_err (resp.status);
+
+  *list = resp.list;
+  return YPERR_SUCCESS;
+}
+
 int
 main (int argc, char **argv)
 {
-  int dflag = 0, hflag = 0, mflag = 0, tflag = 0, xflag = 0;
+  int dflag = 0, hflag = 0, mflag = 0, tflag = 0, xflag = 0, aflag = 0;
+  int stats = 0, jobs = DEFAULT_JOBS;
   char *domainname = NULL;
   char *hostname = NULL;
+  char *outdir = NULL;
+  char *cachedir = NULL;
 
   setlocale (LC_MESSAGES, "");
   setlocale (LC_CTYPE, "");
@@ -131,15 +329,24 @@ main (int argc, char **argv)
       {
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
+        {"stats", no_argument, NULL, '\253'},
+        {"all", no_argument, NULL, 'a'},
+        {"jobs", required_argument, NULL, 'j'},
+        {"output-dir", required_argument, NULL, 'o'},
+        {"cache", required_argument, NULL, '\252'},
         {"help", no_argument, NULL, '?'},
         {NULL, 0, NULL, '\0'}
       };
 
-      c = getopt_long (argc, argv, "d:h:ktx?", long_options, &option_index);
+      c = getopt_long (argc, argv, "ad:h:j:ko:tx?", long_options,
+		       &option_index);
       if (c == (-1))
         break;
       switch (c)
         {
+	case 'a':
+	  aflag = 1;
+	  break;
 	case 'd':
 	  dflag = 1;
 	  domainname = optarg;
@@ -148,15 +355,32 @@ main (int argc, char **argv)
 	  hflag = 1;
 	  hostname = optarg;
 	  break;
+	case 'j':
+	  jobs = atoi (optarg);
+	  if (jobs < 1)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  break;
 	case 'k':
 	  kflag = 1;
 	  break;
+	case 'o':
+	  outdir = optarg;
+	  break;
 	case 't':
 	  tflag = 1;
 	  break;
 	case 'x':
 	  xflag = 1;
 	  break;
+	case '\253':
+	  stats = 1;
+	  break;
+	case '\252':
+	  cachedir = optarg;
+	  break;
 	case '?':
 	  print_help ();
 	  return 0;
@@ -175,16 +399,12 @@ main (int argc, char **argv)
   argc -= optind;
   argv += optind;
 
-  if (argc > 1)
-    {
-      print_error ();
-      return 1;
-    }
-  else
-    if (argc == 1)
-      mflag = 1;
+  if (argc >= 1)
+    mflag = 1;
 
-  if ((xflag && (hflag || dflag || mflag || tflag)) || (!xflag && !mflag))
+  if ((xflag && (hflag || dflag || mflag || tflag || aflag || outdir ||
+		 cachedir)) ||
+      (aflag && mflag) || (!xflag && !mflag && !aflag))
     {
       print_error ();
       return 1;
@@ -194,9 +414,11 @@ main (int argc, char **argv)
     print_nicknames();
   else
     {
-      struct ypall_callback ypcb;
-      const char *map;
-      int res;
+      struct ypmaplist *ypmap = NULL, *y;
+      struct timespec start, end;
+      unsigned long long records = 0, bytes = 0;
+      int result = 0;
+      size_t i;
 
       if (domainname == NULL)
 	{
@@ -210,30 +432,134 @@ main (int argc, char **argv)
 	    }
 	}
 
-      if (!tflag)
-	map = getypalias (argv[0]);
-      else
-	map = argv[0];
+      /* yp_all serializes all calls, so if we stream more than
+	 one map, we need to know the server. The cache is kept per
+	 server, too.  */
+      if (!hflag && (aflag || argc > 1 || cachedir))
+	{
+	  int error;
 
-      ypcb.foreach = print_data;
-      ypcb.data = NULL;
+	  hostname = __yp_bound_server (domainname, &error);
+	  if (hostname == NULL)
+	    {
+	      if (error == YPERR_YPBIND)
+		fprintf (stderr, _("No running ypbind\n"));
+	      else
+		fprintf (stderr, _("%s: can't get NIS server: %s\n"),
+			 "ypcat", yperr_string (error));
+	      return 1;
+	    }
+	}
+
+      if (aflag)
+	{
+	  int res = get_maplist (domainname, hostname, &ypmap);
 
-      if (hflag)
-	res = yp_all_host (domainname, map, &ypcb, hostname);
+	  if (res != YPERR_SUCCESS)
+	    {
+	      fprintf (stderr,
+		       _("Can't get map list for domain %s. Reason: %s\n"),
+		       domainname, yperr_string (res));
+	      return 1;
+	    }
+	  for (y = ypmap; y; y = y->next)
+	    dump_njobs++;
+	}
       else
-	res = yp_all (domainname, map, &ypcb);
-      switch (res)
+	dump_njobs = argc;
+
+      dump_jobs = calloc (dump_njobs ? dump_njobs : 1,
+			  sizeof (struct dump_job));
+      if (dump_jobs == NULL)
 	{
-	case YPERR_SUCCESS:
-	  break;
-	case YPERR_YPBIND:
-	  fprintf (stderr, _("No running ypbind\n"));
-	  return 1;
-	default:
-	  fprintf (stderr, _("No such map %s. Reason: %s\n"),
-		   map, yperr_string (res));
+	  fprintf (stderr, "ypcat: %s\n", strerror (errno));
 	  return 1;
 	}
+      if (aflag)
+	for (i = 0, y = ypmap; y; y = y->next, i++)
+	  dump_jobs[i].map = y->map;
+      else
+	for (i = 0; i < dump_njobs; i++)
+	  dump_jobs[i].map = tflag ? argv[i] : getypalias (argv[i]);
+
+      dump_domain = domainname;
+      dump_host = hostname;
+      dump_dir = outdir;
+      dump_cache = cachedir;
+
+      clock_gettime (CLOCK_MONOTONIC, &start);
+
+      if (dump_njobs == 1)
+	dump_map (&dump_jobs[0]);
+      else if (dump_njobs > 1)
+	{
+	  pthread_t *threads;
+	  int n;
+
+	  if ((size_t) jobs > dump_njobs)
+	    jobs = dump_njobs;
+	  threads = calloc (jobs, sizeof (pthread_t));
+	  if (threads == NULL)
+	    {
+	      fprintf (stderr, "ypcat: %s\n", strerror (errno));
+	      return 1;
+	    }
+	  for (n = 0; n < jobs; n++)
+	    if (pthread_create (&threads[n], NULL, dump_worker, NULL) != 0)
+	      break;
+	  /* If no thread could be started, do the work ourself */
+	  if (n == 0)
+	    dump_worker (NULL);
+	  while (n > 0)
+	    pthread_join (threads[--n], NULL);
+	  free (threads);
+	}
+
+      clock_gettime (CLOCK_MONOTONIC, &end);
+
+      for (i = 0; i < dump_njobs; i++)
+	{
+	  struct dump_job *job = &dump_jobs[i];
+
+	  records += job->output.records;
+	  bytes += job->output.bytes;
+
+	  if (job->output_errno != 0)
+	    {
+	      fprintf (stderr, _("%s: write error for map %s: %s\n"), "ypcat",
+		       job->map, strerror (job->output_errno));
+	      result = 1;
+	      continue;
+	    }
+	  switch (job->res)
+	    {
+	    case YPERR_SUCCESS:
+	      break;
+	    case YPERR_YPBIND:
+	      fprintf (stderr, _("No running ypbind\n"));
+	      result = 1;
+	      break;
+	    default:
+	      fprintf (stderr, _("No such map %s. Reason: %s\n"),
+		       job->map, yperr_string (job->res));
+	      result = 1;
+	      break;
+	    }
+	}
+
+      if (stats)
+	{
+	  double secs = (end.tv_sec - start.tv_sec) +
+	    (end.tv_nsec - start.tv_nsec) / 1e9;
+
+	  if (secs <= 0)
+	    secs = 1e-9;
+	  fprintf (stderr,
+		   _("%llu records, %llu bytes in %.3f s (%.0f records/s, %.0f bytes/s)\n"),
+		   records, bytes, secs, records / secs, bytes / secs);
+	}
+
+      return result;
     }
   return 0;
 }
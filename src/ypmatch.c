@@ -27,8 +27,16 @@
 #include <netdb.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <rpc/rpc.h>
 #include <rpcsvc/ypclnt.h>
+#include <rpcsvc/yp_prot.h>
 #include "lib/nicknames.h"
+#include "lib/internal.h"
+#include "lib/rpcpipe.h"
+#include "lib/yp_all_host.h"
+#include "lib/yp_order_host.h"
+#include "lib/ypsnap.h"
 
 #ifndef _
 #define _(String) gettext (String)
@@ -51,7 +59,11 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: ypmatch [-d domain] [-kt] key ... mapname | -x\n"),
+  fputs (_("Usage: ypmatch [-d domain] [-kt] [-w window] [--cache dir]\n"
+	   "               key ... mapname\n"
+	   "       ypmatch [-d domain] [-kt] [-w window] [--cache dir]\n"
+	   "               --keys-from file mapname\n"
+	   "       ypmatch -x\n"),
 	 stream);
 }
 
@@ -65,8 +77,14 @@ print_help (void)
 	 stdout);
   fputs (_("  -k             Display map keys\n"), stdout);
   fputs (_("  -t             Inhibits map nickname translation\n"), stdout);
+  fputs (_("  -w window      Keep up to 'window' queries in flight\n"), stdout);
+  fputs (_("      --keys-from file\n"
+	   "                 Read the keys from 'file', one per line, or from\n"
+	   "                 stdin if 'file' is '-'\n"), stdout);
   fputs (_("  -x             Display the map nickname translation table\n"),
 	 stdout);
+  fputs (_("      --cache dir  Remember in 'dir' if the keys of the map end\n"
+	   "                 with a NUL byte\n"), stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -83,12 +101,541 @@ print_error (void)
 	   program, program);
 }
 
+#define DEFAULT_WINDOW 32
+
+/* Print the result of one key. Returns 1 if the key was not found
+   or the query failed.  */
+static int
+print_match (int res, const char *key, const char *map, char *val,
+	     int vallen, int kflag)
+{
+  switch (res)
+    {
+    case YPERR_SUCCESS:
+      if (vallen > 0 && val[vallen - 1] == '\0')
+	--vallen;
+      if (kflag)
+	printf ("%s ", key);
+      printf ("%*.*s\n", vallen, vallen, val);
+      return 0;
+    case YPERR_YPBIND:
+      fprintf (stderr, _("No running ypbind\n"));
+      return 1;
+    default:
+      fprintf (stderr, _("Can't match key %s in map %s. Reason: %s\n"),
+	       key, map, yperr_string (res));
+      return 1;
+    }
+}
+
+/* Where the keys come from: the command line or a file, which
+   is read while the queries are running.  */
+struct key_source
+{
+  char **argv;
+  size_t argc;
+  size_t next;
+  FILE *fp;
+  const char *name;
+  int error;
+};
+
+/* Read the next key from the file into *buf. Empty lines are
+   skipped.  */
+static char *
+read_key (struct key_source *src, char **buf, size_t *size)
+{
+  ssize_t n;
+
+  while ((n = getline (buf, size, src->fp)) >= 0)
+    {
+      if (n > 0 && (*buf)[n - 1] == '\n')
+	(*buf)[--n] = '\0';
+      if (n > 0)
+	return *buf;
+    }
+  if (ferror (src->fp))
+    {
+      fprintf (stderr, _("ypmatch: can't read keys from %s: %m\n"),
+	       src->name);
+      src->error = 1;
+    }
+  return NULL;
+}
+
+/* Return the next key, or NULL at the end. The keys in argv come
+   first, then the keys from the file.  */
+static char *
+next_key (struct key_source *src, char **buf, size_t *size)
+{
+  if (src->next < src->argc)
+    return src->argv[src->next++];
+  if (src->fp == NULL)
+    return NULL;
+  return read_key (src, buf, size);
+}
+
+/* Read up to limit keys from the file into argv, so that we know
+   if there are more. Returns -1 if there is not enough memory.  */
+static int
+read_ahead (struct key_source *src, size_t limit)
+{
+  src->argv = calloc (limit, sizeof (char *));
+  if (src->argv == NULL)
+    return -1;
+
+  while (src->argc < limit)
+    {
+      char *line = NULL;
+      size_t size = 0;
+
+      if (read_key (src, &line, &size) == NULL)
+	{
+	  free (line);
+	  break;
+	}
+      src->argv[src->argc++] = line;
+    }
+  return 0;
+}
+
+struct match_key
+{
+  const char *key;
+  /* Line buffer, if the keys are read from a file */
+  char *buf;
+  size_t bufsize;
+  struct ypreq_key req;
+  struct ypresp_val resp;
+  /* The key was sent with the NUL byte at the end */
+  int nul;
+  /* No second try with the other form of the key */
+  int retried;
+  int done;
+  int res;
+  /* resp has to be freed */
+  int has_resp;
+};
+
+/* Keys are kept in a ring, so only a bounded number of keys is in
+   memory, and the results can be printed in the order of the keys.  */
+#define RING_FACTOR 4
+
+struct match_batch
+{
+  const char *domain;
+  const char *map;
+  struct key_source *src;
+  struct match_key *mk;
+  size_t nring;
+  /* Number of keys read and printed so far */
+  size_t next;
+  size_t printed;
+  size_t *retry;
+  size_t nretry;
+  /* How the keys are stored, learned from the first hit */
+  enum ypsnap_keymode keymode;
+  int kflag;
+  /* Report a missing key and go on with the next one */
+  int keep_going;
+  int missing;
+  int failed;
+};
+
+static int
+match_next (void *data, struct rpcpipe_call *call)
+{
+  struct match_batch *b = data;
+  struct match_key *k;
+
+  if (b->failed)
+    return 0;
+
+  if (b->nretry > 0)
+    k = &b->mk[b->retry[--b->nretry]];
+  else
+    {
+      const char *key;
+
+      /* The oldest key has to be printed before its slot in
+	 the ring can be used again.  */
+      if (b->next - b->printed >= b->nring)
+	return 0;
+      k = &b->mk[b->next % b->nring];
+      key = next_key (b->src, &k->buf, &k->bufsize);
+      if (key == NULL)
+	{
+	  if (b->src->error)
+	    b->failed = 1;
+	  return 0;
+	}
+      b->next++;
+      k->key = key;
+      k->nul = (b->keymode == YPSNAP_KEYS_NUL);
+      k->retried = (b->keymode != YPSNAP_KEYS_UNKNOWN);
+      k->done = 0;
+      k->has_resp = 0;
+      k->req.domain = (char *) b->domain;
+      k->req.map = (char *) b->map;
+      k->req.keydat.keydat_val = (char *) key;
+      k->req.keydat.keydat_len = strlen (key) + k->nul;
+    }
+
+  call->proc = YPPROC_MATCH;
+  call->inproc = (xdrproc_t) xdr_ypreq_key;
+  call->in = (caddr_t) &k->req;
+  call->outproc = (xdrproc_t) xdr_ypresp_val;
+  call->out = (caddr_t) &k->resp;
+  call->data = k;
+  memset (&k->resp, 0, sizeof (struct ypresp_val));
+
+  return 1;
+}
+
+static void
+match_done (void *data, struct rpcpipe_call *call)
+{
+  struct match_batch *b = data;
+  struct match_key *k = call->data;
+
+  if (call->stat != RPC_SUCCESS)
+    k->res = YPERR_RPC;
+  else
+    {
+      k->res = ypprot_err (k->resp.status);
+      if (k->res == YPERR_KEY && !k->retried)
+	{
+	  xdr_free ((xdrproc_t) xdr_ypresp_val, (char *) &k->resp);
+	  k->retried = 1;
+	  k->nul = 1;
+	  k->req.keydat.keydat_len++;
+	  b->retry[b->nretry++] = k - b->mk;
+	  return;
+	}
+      if (k->res == YPERR_SUCCESS && b->keymode == YPSNAP_KEYS_UNKNOWN)
+	b->keymode = k->nul ? YPSNAP_KEYS_NUL : YPSNAP_KEYS_PLAIN;
+    }
+  k->done = 1;
+  k->has_resp = (call->stat == RPC_SUCCESS);
+
+  /* Print everything we have in the order of the keys.  */
+  while (!b->failed && b->printed < b->next &&
+	 b->mk[b->printed % b->nring].done)
+    {
+      struct match_key *p = &b->mk[b->printed % b->nring];
+
+      if (print_match (p->res, p->key, b->map, p->resp.valdat.valdat_val,
+		       p->resp.valdat.valdat_len, b->kflag))
+	{
+	  if (b->keep_going && p->res == YPERR_KEY)
+	    b->missing = 1;
+	  else
+	    b->failed = 1;
+	}
+      if (p->has_resp)
+	xdr_free ((xdrproc_t) xdr_ypresp_val, (char *) &p->resp);
+      p->has_resp = 0;
+      b->printed++;
+    }
+}
+
+/* Query all keys over one UDP socket with up to window queries in
+   flight. Returns -1 if this is not possible, so that the caller
+   can use yp_match.  */
+static int
+match_pipelined (const char *server, char *domain, const char *map,
+		 struct key_source *src, unsigned int window, int kflag,
+		 int keep_going, enum ypsnap_keymode *keymode)
+{
+  struct match_batch b;
+  struct rpcpipe *pipe;
+  size_t i;
+  int ret;
+
+  pipe = rpcpipe_create (server, YPPROG, YPVERS);
+  if (pipe == NULL)
+    return -1;
+
+  memset (&b, 0, sizeof (b));
+  b.domain = domain;
+  b.map = map;
+  b.src = src;
+  b.kflag = kflag;
+  b.keep_going = keep_going;
+  b.keymode = *keymode;
+  b.nring = (size_t) window * RING_FACTOR;
+  b.mk = calloc (b.nring, sizeof (struct match_key));
+  b.retry = calloc (b.nring, sizeof (size_t));
+  if (b.mk == NULL || b.retry == NULL)
+    {
+      free (b.mk);
+      free (b.retry);
+      rpcpipe_destroy (pipe);
+      return -1;
+    }
+
+  ret = rpcpipe_run (pipe, window, match_next, match_done, &b);
+  rpcpipe_destroy (pipe);
+  *keymode = b.keymode;
+
+  for (i = 0; i < b.nring; i++)
+    {
+      if (b.mk[i].has_resp)
+	xdr_free ((xdrproc_t) xdr_ypresp_val, (char *) &b.mk[i].resp);
+      free (b.mk[i].buf);
+    }
+  free (b.mk);
+  free (b.retry);
+
+  if (ret != 0 || b.failed || b.missing)
+    return 1;
+  return 0;
+}
+
+/* If the number of keys is at least 1/BULK_RATIO of the size of the
+   map, fetching the whole map with one YPPROC_ALL stream is cheaper
+   than a YPPROC_MATCH call for every key.  */
+#define BULK_RATIO 8
+
+/* Open addressing hash table with linear probing for the records
+   of a map.  */
+struct join_entry
+{
+  char *key;
+  char *val;
+  int keylen;
+  int vallen;
+};
+
+struct join_table
+{
+  struct join_entry *slots;
+  size_t size;
+  size_t count;
+  struct ypsnap_writer snap;
+  int snapping;
+  int nomem;
+};
+
+static uint32_t
+join_hash (const char *key, int keylen)
+{
+  uint32_t h = 2166136261u;
+  int i;
+
+  for (i = 0; i < keylen; i++)
+    {
+      h ^= (unsigned char) key[i];
+      h *= 16777619;
+    }
+  return h;
+}
+
+static struct join_entry *
+join_slot (struct join_entry *slots, size_t size, const char *key,
+	   int keylen)
+{
+  size_t i = join_hash (key, keylen) & (size - 1);
+
+  while (slots[i].key != NULL &&
+	 (slots[i].keylen != keylen ||
+	  memcmp (slots[i].key, key, keylen) != 0))
+    i = (i + 1) & (size - 1);
+  return &slots[i];
+}
+
+/* Keep the table at most half full.  */
+static int
+join_grow (struct join_table *t, size_t count)
+{
+  struct join_entry *slots;
+  size_t size = 16, i;
+
+  while (size < 2 * count)
+    size *= 2;
+  if (size <= t->size)
+    return 0;
+
+  slots = calloc (size, sizeof (struct join_entry));
+  if (slots == NULL)
+    return -1;
+  for (i = 0; i < t->size; i++)
+    if (t->slots[i].key != NULL)
+      *join_slot (slots, size, t->slots[i].key, t->slots[i].keylen) =
+	t->slots[i];
+  free (t->slots);
+  t->slots = slots;
+  t->size = size;
+  return 0;
+}
+
+static const struct join_entry *
+join_find (const struct join_table *t, const char *key, int keylen)
+{
+  const struct join_entry *e = join_slot (t->slots, t->size, key, keylen);
+
+  return e->key != NULL ? e : NULL;
+}
+
+static int
+join_add (int status, char *inkey, int inkeylen, char *inval,
+	  int invallen, char *indata)
+{
+  struct join_table *t = (struct join_table *) indata;
+  struct join_entry *e;
+
+  if (status != YP_TRUE)
+    return status;
+
+  if (t->snapping)
+    ypsnap_add (&t->snap, inkey, inkeylen, inval, invallen);
+
+  if (join_grow (t, t->count + 1) != 0)
+    {
+      t->nomem = 1;
+      return 1;
+    }
+  e = join_slot (t->slots, t->size, inkey, inkeylen);
+  if (e->key != NULL)
+    return 0;
+  e->key = malloc (inkeylen + invallen + 2);
+  if (e->key == NULL)
+    {
+      t->nomem = 1;
+      return 1;
+    }
+  memcpy (e->key, inkey, inkeylen);
+  e->key[inkeylen] = '\0';
+  e->val = e->key + inkeylen + 1;
+  memcpy (e->val, inval, invallen);
+  e->val[invallen] = '\0';
+  e->keylen = inkeylen;
+  e->vallen = invallen;
+  t->count++;
+
+  return 0;
+}
+
+static void
+join_free (struct join_table *t)
+{
+  size_t i;
+
+  for (i = 0; i < t->size; i++)
+    free (t->slots[i].key);
+  free (t->slots);
+}
+
+/* Load the whole map into a hash table, from the snapshot if it
+   is still valid, else with YPPROC_ALL from server, and answer all
+   keys from it. The output is the same as with YPPROC_MATCH. Returns
+   -1 if the map could not be loaded, so that the caller can fall
+   back to one query per key.  */
+static int
+match_bulk (const char *server, char *domain, const char *map,
+	    struct key_source *src, size_t count, int kflag, int keep_going,
+	    const char *snappath, unsigned int order,
+	    enum ypsnap_keymode *keymode)
+{
+  struct ypall_callback ypcb;
+  struct join_table t;
+  const char *key;
+  char *line = NULL;
+  size_t linesize = 0;
+  int ret = 0;
+
+  memset (&t, 0, sizeof (t));
+  if (join_grow (&t, count) != 0)
+    return -1;
+
+  ypcb.foreach = join_add;
+  ypcb.data = (char *) &t;
+
+  if (ypsnap_foreach (snappath, order, &ypcb) != 0)
+    {
+      int res;
+
+      if (ypsnap_open (&t.snap, snappath) == 0)
+	t.snapping = 1;
+      res = yp_all_host (domain, map, &ypcb, server);
+      if (t.snapping)
+	{
+	  if (res == YPERR_SUCCESS && !t.nomem)
+	    ypsnap_commit (&t.snap, order);
+	  else
+	    ypsnap_abort (&t.snap);
+	}
+      if (res != YPERR_SUCCESS)
+	t.nomem = 1;
+    }
+  if (t.nomem)
+    {
+      join_free (&t);
+      return -1;
+    }
+
+  while ((key = next_key (src, &line, &linesize)) != NULL)
+    {
+      int keylen = strlen (key);
+      const struct join_entry *e = join_find (&t, key, keylen);
+      int res;
+
+      if (e == NULL)
+	e = join_find (&t, key, keylen + 1);
+      if (e != NULL && *keymode == YPSNAP_KEYS_UNKNOWN)
+	*keymode = (e->keylen > keylen) ? YPSNAP_KEYS_NUL : YPSNAP_KEYS_PLAIN;
+
+      res = (e != NULL) ? YPERR_SUCCESS : YPERR_KEY;
+      if (print_match (res, key, map, e ? e->val : NULL, e ? e->vallen : 0,
+		       kflag))
+	{
+	  ret = 1;
+	  if (!keep_going)
+	    break;
+	}
+    }
+  if (src->error)
+    ret = 1;
+
+  free (line);
+  join_free (&t);
+  return ret;
+}
+
+/* Look up one key with yp_match. Until the form of the keys is
+   known, a key which is not found is tried again with the NUL byte
+   at the end.  */
+static int
+match_one (char *domain, const char *map, const char *key,
+	   enum ypsnap_keymode *keymode, char **val, int *vallen)
+{
+  int keylen = strlen (key);
+  int res;
+
+  if (*keymode != YPSNAP_KEYS_UNKNOWN)
+    return yp_match (domain, map, key, keylen + (*keymode == YPSNAP_KEYS_NUL),
+		     val, vallen);
+
+  res = yp_match (domain, map, key, keylen, val, vallen);
+  if (res == YPERR_SUCCESS)
+    *keymode = YPSNAP_KEYS_PLAIN;
+  else if (res == YPERR_KEY)
+    {
+      res = yp_match (domain, map, key, keylen + 1, val, vallen);
+      if (res == YPERR_SUCCESS)
+	*keymode = YPSNAP_KEYS_NUL;
+    }
+  return res;
+}
 
 int
 main (int argc, char **argv)
 {
-  int dflag = 0, kflag = 0, tflag = 0, xflag = 0;
+  int dflag = 0, kflag = 0, tflag = 0, wflag = 0, xflag = 0;
+  unsigned int window = DEFAULT_WINDOW;
   char *domainname = NULL;
+  const char *keyfile = NULL;
+  const char *cachedir = NULL;
 
   setlocale (LC_MESSAGES, "");
   setlocale (LC_CTYPE, "");
@@ -104,10 +651,12 @@ main (int argc, char **argv)
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
         {"help", no_argument, NULL, '?'},
+        {"keys-from", required_argument, NULL, '\253'},
+        {"cache", required_argument, NULL, '\252'},
         {NULL, 0, NULL, '\0'}
       };
 
-      c = getopt_long (argc, argv, "d:ktx?", long_options, &option_index);
+      c = getopt_long (argc, argv, "d:ktw:x?", long_options, &option_index);
       if (c == (-1))
         break;
       switch (c)
@@ -122,9 +671,24 @@ main (int argc, char **argv)
 	case 't':
 	  tflag = 1;
 	  break;
+	case 'w':
+	  wflag = 1;
+	  window = atoi (optarg);
+	  if (window < 1 || window > RPCPIPE_MAXWINDOW)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  break;
 	case 'x':
 	  xflag = 1;
 	  break;
+	case '\253':
+	  keyfile = optarg;
+	  break;
+	case '\252':
+	  cachedir = optarg;
+	  break;
 	case '?':
 	  print_help ();
 	  return 0;
@@ -143,13 +707,15 @@ main (int argc, char **argv)
   argc -= optind;
   argv += optind;
 
-  if (argc < 2 && !xflag)
+  if ((keyfile == NULL && argc < 2 && !xflag) ||
+      (keyfile != NULL && argc != 1))
     {
       print_error ();
       return 1;
     }
 
-  if (xflag && (dflag || kflag || tflag))
+  if (xflag && (dflag || kflag || tflag || wflag || keyfile ||
+		cachedir))
     {
       print_error ();
       return 1;
@@ -159,8 +725,14 @@ main (int argc, char **argv)
     print_nicknames();
   else
     {
-      const char *map;
-      int i;
+      struct key_source src;
+      enum ypsnap_keymode keymode = YPSNAP_KEYS_UNKNOWN, known;
+      const char *map, *key;
+      char *line = NULL, *server = NULL, *snappath = NULL;
+      size_t linesize = 0, i;
+      unsigned int order;
+      long count;
+      int ahead = 0, ret = 0;
 
       if (domainname == NULL)
 	{
@@ -179,35 +751,102 @@ main (int argc, char **argv)
       else
 	map = argv[argc - 1];
 
-      for (i = 0; i < (argc - 1); ++i)
+      memset (&src, 0, sizeof (src));
+      if (keyfile != NULL)
 	{
-	  char *val = NULL;
-	  int vallen, res;
-
-	  res = yp_match (domainname, map, argv[i], strlen (argv[i]),
-			  &val, &vallen);
-	  if (res == YPERR_KEY)
-	    res = yp_match (domainname, map,  argv[i], strlen (argv[i]) + 1,
-			    &val, &vallen);
-	  switch (res)
+	  if (strcmp (keyfile, "-") == 0)
+	    src.fp = stdin;
+	  else if ((src.fp = fopen (keyfile, "r")) == NULL)
 	    {
-	    case YPERR_SUCCESS:
-	      if (val[vallen - 1] == '\0')
-		--vallen;
-	      if (kflag)
-		printf ("%s ", argv[i]);
-	      printf ("%*.*s\n", vallen, vallen, val);
-	      free (val);
-	      break;
-	    case YPERR_YPBIND:
-	      fprintf (stderr, _("No running ypbind\n"));
-	      return 1;
-	    default:
-	      fprintf (stderr, _("Can't match key %s in map %s. Reason: %s\n"),
-		       argv[i], map, yperr_string (res));
+	      fprintf (stderr, _("ypmatch: can't open %s: %m\n"), keyfile);
 	      return 1;
 	    }
+	  src.name = keyfile;
+	}
+      else
+	{
+	  src.argv = argv;
+	  src.argc = argc - 1;
+	}
+
+      /* With more than one key, send all queries at once to the
+	 server ypbind is bound to. The form of the keys is kept per
+	 server, too.  */
+      if (keyfile != NULL || argc > 2 || cachedir != NULL)
+	{
+	  int error;
+
+	  server = __yp_bound_server (domainname, &error);
+	}
+      if (server != NULL && cachedir != NULL &&
+	  yp_order_host (domainname, map, &order, server) == YPERR_SUCCESS &&
+	  (snappath = ypsnap_path (cachedir, domainname, server, map)) != NULL)
+	keymode = ypsnap_keymode_load (snappath, order);
+      known = keymode;
+
+      /* A previous snapshot tells us the size of the map. If a
+	 large part of it is asked for, fetch the whole map.  */
+      ret = -1;
+      if (snappath != NULL && (count = ypsnap_count (snappath)) >= 0)
+	{
+	  size_t limit = count / BULK_RATIO + 1;
+
+	  if (keyfile != NULL)
+	    {
+	      ahead = 1;
+	      if (read_ahead (&src, limit) != 0)
+		{
+		  fputs (_("ypmatch: Out of memory\n"), stderr);
+		  return 1;
+		}
+	    }
+	  if (src.argc >= limit)
+	    ret = match_bulk (server, domainname, map, &src, count, kflag,
+			      keyfile != NULL, snappath, order, &keymode);
+	}
+
+      if (ret < 0 && server != NULL && (keyfile != NULL || argc > 2))
+	ret = match_pipelined (server, domainname, map, &src, window,
+			       kflag, keyfile != NULL, &keymode);
+
+      /* Missing keys from a file are reported, but do not stop
+	 the lookup of the other keys.  */
+      if (ret < 0)
+	{
+	  ret = 0;
+	  while ((key = next_key (&src, &line, &linesize)) != NULL)
+	    {
+	      char *val = NULL;
+	      int vallen, res;
+
+	      res = match_one (domainname, map, key, &keymode, &val, &vallen);
+	      if (print_match (res, key, map, val, vallen, kflag))
+		{
+		  ret = 1;
+		  if (keyfile == NULL || res != YPERR_KEY)
+		    break;
+		}
+	      free (val);
+	    }
+	  if (src.error)
+	    ret = 1;
+	}
+
+      if (snappath != NULL && keymode != known)
+	ypsnap_keymode_save (snappath, order, keymode);
+
+      if (ahead)
+	{
+	  for (i = 0; i < src.argc; i++)
+	    free (src.argv[i]);
+	  free (src.argv);
 	}
+      free (snappath);
+      free (server);
+      free (line);
+      if (src.fp != NULL && src.fp != stdin)
+	fclose (src.fp);
+      return ret;
     }
   return 0;
 }
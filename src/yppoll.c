@@ -23,15 +23,22 @@
 #include <time.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <getopt.h>
 #include <locale.h>
 #include <libintl.h>
 #include <arpa/inet.h>
 #include <rpc/rpc.h>
 #include <rpc/pmap_clnt.h>
+#include <rpc/pmap_prot.h>
 #include <rpcsvc/ypclnt.h>
 #include <rpcsvc/yp_prot.h>
+#include "lib/internal.h"
+#include "lib/rpcpipe.h"
+#include "lib/yp_all_host.h"
+#include "lib/yp_hostaddr.h"
 
 #ifndef _
 #define _(String) gettext (String)
@@ -58,7 +65,9 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: yppoll [-h host] [-d domain] mapname\n"),
+  fputs (_("Usage: yppoll [-h host] [-d domain] mapname | --all\n"
+	   "       yppoll [-h host] [-d domain] --lag [--timeout sec] [mapname ...]\n"
+	   "       yppoll [-h host] [-d domain] --watch [--interval sec] [mapname ...]\n"),
 	 stream);
 }
 
@@ -72,6 +81,17 @@ print_help (void)
   fputs (_("  -h host        Ask ypserv process at 'host'\n"), stdout);
   fputs (_("  -d domain      Use 'domain' instead of the default domain\n"),
 	 stdout);
+  fputs (_("      --all      Print order number and master of all maps\n"),
+	 stdout);
+  fputs (_("      --lag      Compare the maps on all servers in ypservers\n"),
+	 stdout);
+  fputs (_("      --timeout sec  Wait at most 'sec' seconds for a server\n"),
+	 stdout);
+  fputs (_("      --watch    Print every change of order number or master\n"),
+	 stdout);
+  fputs (_("      --interval sec  Poll every 'sec' seconds or less often\n"
+	   "                 while nothing changes\n"),
+	 stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -88,6 +108,900 @@ print_error (void)
 	   program, program);
 }
 
+/* Number of queries in flight with --all */
+#define POLL_WINDOW 64
+
+/* Order number and master of one map */
+struct map_poll
+{
+  char *map;
+  /* Server to ask, if not the one of the pipe */
+  const struct sockaddr *addr;
+  socklen_t addrlen;
+  struct ypreq_nokey req;
+  struct ypresp_order resp_o;
+  struct ypresp_master resp_m;
+  /* YPERR_* of the ORDER and MASTER calls */
+  int res1;
+  int res2;
+  time_t order;
+  char *master;
+};
+
+/* Ask for the order number and the master of all maps at once.  */
+static int
+poll_maps (struct rpcpipe *pipe, char *domain, struct map_poll *maps,
+	   size_t nmaps, unsigned int window)
+{
+  struct rpcpipe_call *calls;
+  size_t i;
+  int ret;
+
+  calls = calloc (2 * nmaps, sizeof (struct rpcpipe_call));
+  if (calls == NULL)
+    return -1;
+
+  for (i = 0; i < nmaps; i++)
+    {
+      struct map_poll *m = &maps[i];
+
+      m->req.domain = domain;
+      m->req.map = m->map;
+      calls[2 * i].addr = calls[2 * i + 1].addr = m->addr;
+      calls[2 * i].addrlen = calls[2 * i + 1].addrlen = m->addrlen;
+      calls[2 * i].proc = YPPROC_ORDER;
+      calls[2 * i].inproc = (xdrproc_t) xdr_ypreq_nokey;
+      calls[2 * i].in = (caddr_t) &m->req;
+      calls[2 * i].outproc = (xdrproc_t) xdr_ypresp_order;
+      calls[2 * i].out = (caddr_t) &m->resp_o;
+      calls[2 * i + 1].proc = YPPROC_MASTER;
+      calls[2 * i + 1].inproc = (xdrproc_t) xdr_ypreq_nokey;
+      calls[2 * i + 1].in = (caddr_t) &m->req;
+      calls[2 * i + 1].outproc = (xdrproc_t) xdr_ypresp_master;
+      calls[2 * i + 1].out = (caddr_t) &m->resp_m;
+    }
+
+  ret = rpcpipe_batch (pipe, calls, 2 * nmaps, window);
+
+  for (i = 0; i < nmaps; i++)
+    {
+      struct map_poll *m = &maps[i];
+
+      if (calls[2 * i].stat != RPC_SUCCESS)
+	m->res1 = YPERR_RPC;
+      else
+	{
+	  m->res1 = ypprot_err (m->resp_o.status);
+	  m->order = m->resp_o.ordernum;
+	  xdr_free ((xdrproc_t) xdr_ypresp_order, (char *) &m->resp_o);
+	}
+
+      if (calls[2 * i + 1].stat != RPC_SUCCESS)
+	m->res2 = YPERR_RPC;
+      else
+	{
+	  m->res2 = ypprot_err (m->resp_m.status);
+	  if (m->res2 == YPERR_SUCCESS &&
+	      (m->master = strdup (m->resp_m.master)) == NULL)
+	    m->res2 = YPERR_RESRC;
+	  xdr_free ((xdrproc_t) xdr_ypresp_master, (char *) &m->resp_m);
+	}
+    }
+
+  free (calls);
+  return ret;
+}
+
+/* Ask the server for all maps of the domain. Returns the number of
+   maps, or -1 and the error in *err.  */
+static ssize_t
+get_maplist (struct rpcpipe *pipe, char *domain, struct map_poll **maps,
+	     int *err)
+{
+  struct ypresp_maplist resp;
+  struct rpcpipe_call call;
+  struct ypmaplist *y;
+  ssize_t n = 0;
+
+  memset (&resp, 0, sizeof (resp));
+  memset (&call, 0, sizeof (call));
+  call.proc = YPPROC_MAPLIST;
+  call.inproc = (xdrproc_t) xdr_domainname;
+  call.in = (caddr_t) &domain;
+  call.outproc = (xdrproc_t) xdr_ypresp_maplist;
+  call.out = (caddr_t) &resp;
+
+  if (rpcpipe_batch (pipe, &call, 1, 1) != 0 || call.stat != RPC_SUCCESS)
+    {
+      *err = YPERR_RPC;
+      return -1;
+    }
+  if (resp.status != YP_TRUE)
+    {
+      *err = ypprot_err (resp.status);
+      xdr_free ((xdrproc_t) xdr_ypresp_maplist, (char *) &resp);
+      return -1;
+    }
+
+  for (y = resp.list; y; y = y->next)
+    n++;
+  *maps = calloc (n ? n : 1, sizeof (struct map_poll));
+  if (*maps == NULL)
+    {
+      *err = YPERR_RESRC;
+      xdr_free ((xdrproc_t) xdr_ypresp_maplist, (char *) &resp);
+      return -1;
+    }
+  for (y = resp.list, n = 0; y; y = y->next, n++)
+    if (((*maps)[n].map = strdup (y->map)) == NULL)
+      {
+	*err = YPERR_RESRC;
+	while (n > 0)
+	  free ((*maps)[--n].map);
+	free (*maps);
+	xdr_free ((xdrproc_t) xdr_ypresp_maplist, (char *) &resp);
+	return -1;
+      }
+  xdr_free ((xdrproc_t) xdr_ypresp_maplist, (char *) &resp);
+
+  return n;
+}
+
+/* Time since the map was built, the order number is the time of
+   the last make in /var/yp.  */
+static const char *
+format_age (time_t order, time_t now, char *buf, size_t buflen)
+{
+  long age = now - order;
+
+  if (order <= 0 || age < 0)
+    snprintf (buf, buflen, "-");
+  else if (age < 60)
+    snprintf (buf, buflen, "%lds", age);
+  else if (age < 60 * 60)
+    snprintf (buf, buflen, "%ldm%02lds", age / 60, age % 60);
+  else if (age < 24 * 60 * 60)
+    snprintf (buf, buflen, "%ldh%02ldm", age / 3600, (age / 60) % 60);
+  else
+    snprintf (buf, buflen, "%ldd%02ldh", age / 86400, (age / 3600) % 24);
+  return buf;
+}
+
+/* Print a table with the order number, master and age of all maps
+   of the domain, with one round trip for the map list and one for
+   all maps.  */
+static int
+poll_all (char *hostname, char *domainname)
+{
+  struct map_poll *maps = NULL;
+  struct rpcpipe *pipe;
+  time_t now;
+  ssize_t nmaps, i;
+  int err, ret = 0;
+
+  pipe = rpcpipe_create (hostname, YPPROG, YPVERS);
+  if (pipe == NULL)
+    {
+      fprintf (stderr, _("Cannot contact %s, no NIS server running or wrong protocol?\n"),
+	       hostname);
+      return 1;
+    }
+
+  nmaps = get_maplist (pipe, domainname, &maps, &err);
+  if (nmaps < 0)
+    {
+      fprintf (stderr, _("Can't get map list for domain %s. Reason: %s\n"),
+	       domainname, yperr_string (err));
+      rpcpipe_destroy (pipe);
+      return 1;
+    }
+
+  if (poll_maps (pipe, domainname, maps, nmaps, POLL_WINDOW) != 0)
+    ret = 1;
+  rpcpipe_destroy (pipe);
+
+  now = time (NULL);
+  printf ("%-24s %-10s %-24s %s\n", _("MAP"), _("ORDER"), _("MASTER"),
+	  _("AGE"));
+  for (i = 0; i < nmaps; i++)
+    {
+      struct map_poll *m = &maps[i];
+      char orderbuf[24], agebuf[24];
+
+      if (m->res1 == YPERR_SUCCESS)
+	snprintf (orderbuf, sizeof (orderbuf), "%ld", (long) m->order);
+      else
+	strcpy (orderbuf, "-");
+      printf ("%-24s %-10s %-24s %s\n", m->map, orderbuf,
+	      m->res2 == YPERR_SUCCESS ? m->master : "-",
+	      m->res1 == YPERR_SUCCESS ?
+	      format_age (m->order, now, agebuf, sizeof (agebuf)) : "-");
+    }
+
+  for (i = 0; i < nmaps; i++)
+    {
+      struct map_poll *m = &maps[i];
+
+      if (m->res1)
+	{
+	  fprintf (stderr, _("Can't get order number for map %s.\n"), m->map);
+	  fprintf (stderr, _("\tReason: %s\n"), yperr_string (m->res1));
+	  ret = 1;
+	}
+      if (m->res2)
+	{
+	  fprintf (stderr, _("Can't get master for map %s.\n"), m->map);
+	  fprintf (stderr, _("\tReason: %s\n"), yperr_string (m->res2));
+	  ret = 1;
+	}
+      free (m->map);
+      free (m->master);
+    }
+  free (maps);
+
+  return ret;
+}
+
+/* The default for --timeout with --lag */
+#define LAG_TIMEOUT 5
+
+/* A NIS server from the ypservers map */
+struct lag_server
+{
+  char *name;
+  struct yp_hostaddr ha;
+  /* Why the server could not be asked, or NULL */
+  const char *error;
+  size_t maps;
+  size_t behind;
+  size_t missing;
+  long maxlag;
+};
+
+struct lag_servers
+{
+  struct lag_server *list;
+  size_t n;
+  size_t size;
+  int failed;
+};
+
+static int
+lag_add_server (int status, char *key, int keylen,
+		char *val __attribute__ ((unused)),
+		int vallen __attribute__ ((unused)), char *data)
+{
+  struct lag_servers *ls = (struct lag_servers *) data;
+  struct lag_server *s;
+
+  if (status != YP_TRUE)
+    return status;
+
+  while (keylen > 0 && (key[keylen - 1] == '\0' || key[keylen - 1] == ' ' ||
+			key[keylen - 1] == '\t' || key[keylen - 1] == '\n'))
+    --keylen;
+  if (keylen <= 0)
+    return 0;
+
+  if (ls->n == ls->size)
+    {
+      size_t size = ls->size ? 2 * ls->size : 16;
+      struct lag_server *tmp = realloc (ls->list,
+					size * sizeof (struct lag_server));
+      if (tmp == NULL)
+	{
+	  ls->failed = 1;
+	  return 1;
+	}
+      ls->list = tmp;
+      ls->size = size;
+    }
+  s = &ls->list[ls->n];
+  memset (s, 0, sizeof (struct lag_server));
+  if ((s->name = strndup (key, keylen)) == NULL)
+    {
+      ls->failed = 1;
+      return 1;
+    }
+  ls->n++;
+
+  return 0;
+}
+
+/* Compare the addresses, but not the ports.  */
+static int
+same_addr (const struct sockaddr_storage *a, const struct sockaddr *b)
+{
+  if (a->ss_family != b->sa_family)
+    return 0;
+  if (a->ss_family == AF_INET6)
+    return memcmp (&((const struct sockaddr_in6 *) a)->sin6_addr,
+		   &((const struct sockaddr_in6 *) b)->sin6_addr,
+		   sizeof (struct in6_addr)) == 0;
+  return ((const struct sockaddr_in *) a)->sin_addr.s_addr ==
+    ((const struct sockaddr_in *) b)->sin_addr.s_addr;
+}
+
+/* Resolve all servers and ask the portmapper of every one at once
+   for the port of ypserv. The lookups count against the timeout of
+   the pipe.  */
+static void
+lag_getports (struct rpcpipe *pipe, struct lag_server *servers, size_t n)
+{
+  struct rpcpipe_call *calls;
+  struct yp_hostaddr **ha;
+  size_t i, ncalls = 0;
+
+  calls = calloc (n ? n : 1, sizeof (struct rpcpipe_call));
+  ha = calloc (n ? n : 1, sizeof (struct yp_hostaddr *));
+  if (calls == NULL || ha == NULL)
+    {
+      free (calls);
+      free (ha);
+      for (i = 0; i < n; i++)
+	servers[i].error = yperr_string (YPERR_RESRC);
+      return;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      servers[i].ha.name = servers[i].name;
+      ha[i] = &servers[i].ha;
+    }
+  yp_resolve_hosts (ha, n, &pipe->timeout);
+  free (ha);
+
+  for (i = 0; i < n; i++)
+    {
+      struct lag_server *s = &servers[i];
+      struct rpcpipe_call *call;
+      struct timeval left;
+
+      if (s->ha.error)
+	{
+	  s->error = yp_hostaddr_error (&s->ha);
+	  continue;
+	}
+      if (!yp_hostaddr_left (&s->ha, &pipe->timeout, &left))
+	{
+	  s->error = clnt_sperrno (RPC_TIMEDOUT);
+	  continue;
+	}
+
+      call = &calls[ncalls++];
+      yp_hostaddr_getport (&s->ha, YPPROG, YPVERS, call);
+      call->timeout = left;
+      call->data = s;
+    }
+
+  if (ncalls > 0)
+    rpcpipe_batch (pipe, calls, ncalls,
+		   ncalls < RPCPIPE_MAXWINDOW ? ncalls : RPCPIPE_MAXWINDOW);
+
+  for (i = 0; i < ncalls; i++)
+    {
+      struct lag_server *s = calls[i].data;
+
+      if (calls[i].stat != RPC_SUCCESS)
+	s->error = clnt_sperrno (calls[i].stat);
+      else if (s->ha.port == 0 || s->ha.port > 0xffff)
+	s->error = yperr_string (YPERR_YPSERV);
+      else
+	yp_hostaddr_setport (&s->ha, s->ha.port);
+    }
+  free (calls);
+}
+
+/* The server which is the master of the map, or NULL if it is not
+   in the list.  */
+static struct lag_server *
+lag_find_master (struct lag_server **up, size_t nup, const char *master)
+{
+  struct addrinfo hints, *res, *ai;
+  struct lag_server *found = NULL;
+  size_t i;
+
+  for (i = 0; i < nup; i++)
+    if (strcasecmp (up[i]->name, master) == 0)
+      return up[i];
+
+  /* ypservers may use other names for the same hosts.  */
+  memset (&hints, 0, sizeof (hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  if (getaddrinfo (master, NULL, &hints, &res) != 0)
+    return NULL;
+  for (ai = res; ai && found == NULL; ai = ai->ai_next)
+    for (i = 0; i < nup; i++)
+      if (same_addr (&up[i]->ha.addr, ai->ai_addr))
+	{
+	  found = up[i];
+	  break;
+	}
+  freeaddrinfo (res);
+
+  return found;
+}
+
+/* Ask every server in the ypservers map for the order number and
+   master of every map at the same time, and print how far each
+   server is behind the master. All queries are sent at once, so the
+   whole matrix needs about one round trip after the ports are
+   known.  */
+static int
+poll_lag (char *hostname, char *domainname, char **mapv, int mapc,
+	  time_t timeout)
+{
+  struct lag_servers ls;
+  struct lag_server **up = NULL;
+  struct map_poll *maps = NULL, *polls = NULL;
+  struct ypall_callback ypcb;
+  struct rpcpipe *pipe;
+  ssize_t nmaps, i, j;
+  size_t nup = 0, window;
+  char *lastmaster = NULL;
+  struct lag_server *master = NULL;
+  int err, header = 0, nomaster = 0, ret = 0;
+
+  memset (&ls, 0, sizeof (ls));
+
+  if (mapc == 0)
+    {
+      pipe = rpcpipe_create (hostname, YPPROG, YPVERS);
+      if (pipe == NULL)
+	{
+	  fprintf (stderr, _("Cannot contact %s, no NIS server running or wrong protocol?\n"),
+		   hostname);
+	  return 1;
+	}
+      nmaps = get_maplist (pipe, domainname, &maps, &err);
+      rpcpipe_destroy (pipe);
+      if (nmaps < 0)
+	{
+	  fprintf (stderr, _("Can't get map list for domain %s. Reason: %s\n"),
+		   domainname, yperr_string (err));
+	  return 1;
+	}
+    }
+  else
+    {
+      nmaps = mapc;
+      maps = calloc (nmaps, sizeof (struct map_poll));
+      if (maps == NULL)
+	{
+	  fprintf (stderr, "yppoll: %s\n", yperr_string (YPERR_RESRC));
+	  return 1;
+	}
+      for (j = 0; j < nmaps; j++)
+	if ((maps[j].map = strdup (mapv[j])) == NULL)
+	  {
+	    fprintf (stderr, "yppoll: %s\n", yperr_string (YPERR_RESRC));
+	    ret = 1;
+	    goto out;
+	  }
+    }
+
+  ypcb.foreach = lag_add_server;
+  ypcb.data = (char *) &ls;
+  err = yp_all_host (domainname, "ypservers", &ypcb, hostname);
+  if (err != YPERR_SUCCESS || ls.failed)
+    {
+      fprintf (stderr, _("Can't get the list of servers from %s. Reason: %s\n"),
+	       hostname, yperr_string (ls.failed ? YPERR_RESRC : err));
+      ret = 1;
+      goto out;
+    }
+  if (ls.n == 0)
+    {
+      fprintf (stderr, _("No servers in the ypservers map of %s.\n"),
+	       hostname);
+      ret = 1;
+      goto out;
+    }
+
+  pipe = rpcpipe_open ();
+  if (pipe == NULL)
+    {
+      fprintf (stderr, "yppoll: %s\n", clnt_spcreateerror ("rpcpipe"));
+      ret = 1;
+      goto out;
+    }
+  pipe->prog = YPPROG;
+  pipe->vers = YPVERS;
+  pipe->timeout.tv_sec = timeout;
+  pipe->timeout.tv_usec = 0;
+
+  lag_getports (pipe, ls.list, ls.n);
+
+  up = calloc (ls.n, sizeof (struct lag_server *));
+  if (up == NULL)
+    {
+      rpcpipe_destroy (pipe);
+      fprintf (stderr, "yppoll: %s\n", yperr_string (YPERR_RESRC));
+      ret = 1;
+      goto out;
+    }
+  for (i = 0; i < (ssize_t) ls.n; i++)
+    if (ls.list[i].error == NULL)
+      up[nup++] = &ls.list[i];
+
+  /* One row per map with one column per server, so that the calls
+     for the servers alternate.  */
+  if (nup > 0 && nmaps > 0)
+    {
+      polls = calloc (nmaps * nup, sizeof (struct map_poll));
+      if (polls == NULL)
+	{
+	  rpcpipe_destroy (pipe);
+	  fprintf (stderr, "yppoll: %s\n", yperr_string (YPERR_RESRC));
+	  ret = 1;
+	  goto out;
+	}
+      for (j = 0; j < nmaps; j++)
+	for (i = 0; i < (ssize_t) nup; i++)
+	  {
+	    struct map_poll *p = &polls[j * nup + i];
+
+	    p->map = maps[j].map;
+	    p->addr = (struct sockaddr *) &up[i]->ha.addr;
+	    p->addrlen = up[i]->ha.addrlen;
+	  }
+      /* The ORDER and MASTER calls of the whole matrix */
+      window = 2 * nmaps * nup;
+      if (window > RPCPIPE_MAXWINDOW)
+	window = RPCPIPE_MAXWINDOW;
+      if (poll_maps (pipe, domainname, polls, nmaps * nup, window) != 0)
+	ret = 1;
+    }
+  rpcpipe_destroy (pipe);
+
+  for (j = 0; j < nmaps && nup > 0; j++)
+    {
+      struct map_poll *row = &polls[j * nup];
+      struct lag_server *ref = NULL;
+      const char *mastername = NULL;
+      time_t reforder = 0;
+
+      for (i = 0; i < (ssize_t) nup; i++)
+	if (row[i].res2 == YPERR_SUCCESS)
+	  {
+	    mastername = row[i].master;
+	    break;
+	  }
+      if (mastername != NULL)
+	{
+	  if (lastmaster == NULL || strcmp (lastmaster, mastername) != 0)
+	    {
+	      free (lastmaster);
+	      lastmaster = strdup (mastername);
+	      master = lag_find_master (up, nup, mastername);
+	    }
+	  ref = master;
+	}
+      if (ref != NULL)
+	{
+	  for (i = 0; i < (ssize_t) nup; i++)
+	    if (up[i] == ref)
+	      break;
+	  if (row[i].res1 == YPERR_SUCCESS)
+	    reforder = row[i].order;
+	  else
+	    ref = NULL;
+	}
+      if (ref == NULL)
+	{
+	  /* Without the master compare with the newest copy.  */
+	  for (i = 0; i < (ssize_t) nup; i++)
+	    if (row[i].res1 == YPERR_SUCCESS && row[i].order > reforder)
+	      reforder = row[i].order;
+	  if (!nomaster)
+	    fprintf (stderr, _("No order number from the master of %s, comparing with the newest copy.\n"),
+		     maps[j].map);
+	  nomaster = 1;
+	}
+
+      for (i = 0; i < (ssize_t) nup; i++)
+	{
+	  struct map_poll *p = &row[i];
+	  const char *note = NULL;
+	  char orderbuf[24], lagbuf[24];
+	  long lag = 0;
+
+	  if (p->res1 == YPERR_MAP)
+	    {
+	      up[i]->missing++;
+	      note = _("missing");
+	    }
+	  else if (p->res1 != YPERR_SUCCESS)
+	    note = yperr_string (p->res1);
+	  else
+	    {
+	      up[i]->maps++;
+	      lag = reforder - p->order;
+	      if (lag > 0)
+		{
+		  up[i]->behind++;
+		  if (lag > up[i]->maxlag)
+		    up[i]->maxlag = lag;
+		  note = _("behind");
+		}
+	      else if (lag < 0)
+		note = _("ahead of master");
+	      else if (p->res2 == YPERR_SUCCESS && mastername != NULL &&
+		       strcasecmp (p->master, mastername) != 0)
+		note = _("other master");
+	    }
+	  if (note == NULL)
+	    continue;
+
+	  ret = 1;
+	  if (!header)
+	    {
+	      printf ("%-24s %-24s %-10s %-8s %s\n", _("MAP"), _("SERVER"),
+		      _("ORDER"), _("LAG"), _("STATUS"));
+	      header = 1;
+	    }
+	  if (p->res1 == YPERR_SUCCESS)
+	    {
+	      snprintf (orderbuf, sizeof (orderbuf), "%ld", (long) p->order);
+	      snprintf (lagbuf, sizeof (lagbuf), "%ld", lag);
+	    }
+	  else
+	    strcpy (orderbuf, strcpy (lagbuf, "-"));
+	  printf ("%-24s %-24s %-10s %-8s %s\n", maps[j].map, up[i]->name,
+		  orderbuf, lagbuf, note);
+	}
+    }
+
+  if (header)
+    fputc ('\n', stdout);
+  printf ("%-24s %-6s %-6s %-7s %s\n", _("SERVER"), _("MAPS"), _("BEHIND"),
+	  _("MISSING"), _("MAX LAG"));
+  for (i = 0; i < (ssize_t) ls.n; i++)
+    {
+      struct lag_server *s = &ls.list[i];
+
+      if (s->error != NULL)
+	{
+	  printf ("%-24s %-6s %-6s %-7s %s\n", s->name, "-", "-", "-", "-");
+	  fprintf (stderr, "yppoll: %s: %s\n", s->name, s->error);
+	  ret = 1;
+	}
+      else
+	printf ("%-24s %-6zu %-6zu %-7zu %ld\n", s->name, s->maps, s->behind,
+		s->missing, s->maxlag);
+    }
+
+ out:
+  if (polls != NULL)
+    for (i = 0; i < (ssize_t) (nmaps * nup); i++)
+      free (polls[i].master);
+  free (polls);
+  free (up);
+  free (lastmaster);
+  for (i = 0; i < (ssize_t) ls.n; i++)
+    free (ls.list[i].name);
+  free (ls.list);
+  for (j = 0; j < nmaps; j++)
+    free (maps[j].map);
+  free (maps);
+
+  return ret;
+}
+
+/* First interval between two polls with --watch. It doubles while
+   nothing changes, up to WATCH_BACKOFF times the first one.  */
+#define WATCH_INTERVAL 10
+#define WATCH_BACKOFF 16
+
+/* What --watch knows about a map */
+struct watch_state
+{
+  char *map;
+  char order[24];
+  /* NULL if the master is not known */
+  char *master;
+};
+
+static void
+watch_event (const char *map, const char *what, const char *from,
+	     const char *to)
+{
+  char stamp[32];
+  time_t now = time (NULL);
+  struct tm tm;
+
+  strftime (stamp, sizeof (stamp), "%Y-%m-%dT%H:%M:%S",
+	    localtime_r (&now, &tm));
+  printf ("%s %s %s %s %s\n", stamp, map, what, from, to);
+}
+
+/* Print the differences between the last and this poll. Returns
+   the number of events.  */
+static int
+watch_compare (struct watch_state *prev, size_t nprev,
+	       struct watch_state *cur, size_t ncur)
+{
+  size_t i, j, hint = 0;
+  int events = 0;
+
+  for (i = 0; i < ncur; i++)
+    {
+      struct watch_state *p = NULL;
+
+      /* The map list comes always in the same order.  */
+      for (j = 0; j < nprev; j++)
+	{
+	  size_t k = (hint + j) % nprev;
+
+	  if (prev[k].map != NULL && strcmp (prev[k].map, cur[i].map) == 0)
+	    {
+	      p = &prev[k];
+	      hint = k + 1;
+	      break;
+	    }
+	}
+
+      if (p == NULL || strcmp (p->order, cur[i].order) != 0)
+	{
+	  watch_event (cur[i].map, "order", p ? p->order : "-",
+		       cur[i].order);
+	  events++;
+	}
+      if (p == NULL || (p->master == NULL) != (cur[i].master == NULL) ||
+	  (p->master != NULL && strcmp (p->master, cur[i].master) != 0))
+	{
+	  watch_event (cur[i].map, "master",
+		       p && p->master ? p->master : "-",
+		       cur[i].master ? cur[i].master : "-");
+	  events++;
+	}
+      if (p != NULL)
+	{
+	  /* Seen, all which are left are gone.  */
+	  free (p->map);
+	  p->map = NULL;
+	}
+    }
+
+  for (j = 0; j < nprev; j++)
+    if (prev[j].map != NULL)
+      {
+	watch_event (prev[j].map, "order", prev[j].order, "-");
+	events++;
+      }
+
+  return events;
+}
+
+static void
+watch_free (struct watch_state *states, size_t n)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    {
+      free (states[i].map);
+      free (states[i].master);
+    }
+  free (states);
+}
+
+/* Poll the order numbers and masters of the maps with one client
+   for the whole run and print a line for every change since the
+   first poll. The interval
+   grows while nothing changes and goes back to the start with the
+   first change.  */
+static int
+poll_watch (char *hostname, char *domainname, char **mapv, int mapc,
+	    time_t interval)
+{
+  struct watch_state *prev = NULL;
+  size_t nprev = 0;
+  struct rpcpipe *pipe = NULL;
+  const char *lasterr = NULL;
+  time_t wait = interval;
+
+  while (1)
+    {
+      struct map_poll *maps = NULL;
+      struct watch_state *cur;
+      const char *error = NULL;
+      ssize_t nmaps = 0, i;
+      int err;
+
+      if (pipe == NULL &&
+	  (pipe = rpcpipe_create (hostname, YPPROG, YPVERS)) == NULL)
+	error = _("no NIS server running or wrong protocol?");
+      else if (mapc == 0)
+	{
+	  nmaps = get_maplist (pipe, domainname, &maps, &err);
+	  if (nmaps < 0)
+	    error = yperr_string (err);
+	}
+      else
+	{
+	  maps = calloc (mapc, sizeof (struct map_poll));
+	  if (maps == NULL)
+	    error = yperr_string (YPERR_RESRC);
+	  else
+	    for (nmaps = 0; nmaps < mapc; nmaps++)
+	      if ((maps[nmaps].map = strdup (mapv[nmaps])) == NULL)
+		{
+		  error = yperr_string (YPERR_RESRC);
+		  break;
+		}
+	}
+
+      /* The domain may have no maps at all, that is an answer,
+	 too.  */
+      if (error == NULL && nmaps > 0)
+	{
+	  poll_maps (pipe, domainname, maps, nmaps, POLL_WINDOW);
+	  /* If nothing answered, ypserv may have been restarted on
+	     another port, ask the portmapper again next time.  */
+	  error = yperr_string (YPERR_RPC);
+	  for (i = 0; i < nmaps; i++)
+	    if (maps[i].res1 != YPERR_RPC || maps[i].res2 != YPERR_RPC)
+	      error = NULL;
+	}
+
+      if (error != NULL)
+	{
+	  if (pipe != NULL)
+	    {
+	      rpcpipe_destroy (pipe);
+	      pipe = NULL;
+	    }
+	  if (lasterr == NULL || strcmp (lasterr, error) != 0)
+	    fprintf (stderr, "yppoll: %s: %s\n", hostname, error);
+	  lasterr = error;
+	}
+      else if ((cur = calloc (nmaps ? nmaps : 1,
+			      sizeof (struct watch_state))) != NULL)
+	{
+	  lasterr = NULL;
+	  for (i = 0; i < nmaps; i++)
+	    {
+	      struct map_poll *m = &maps[i];
+
+	      /* Keep the names, they are freed with the states.  */
+	      cur[i].map = m->map;
+	      m->map = NULL;
+	      if (m->res1 == YPERR_SUCCESS)
+		snprintf (cur[i].order, sizeof (cur[i].order), "%ld",
+			  (long) m->order);
+	      else
+		strcpy (cur[i].order, "-");
+	      cur[i].master = m->master;
+	      m->master = NULL;
+	    }
+
+	  /* The first poll is only the state to compare with.  */
+	  if (prev == NULL || watch_compare (prev, nprev, cur, nmaps) > 0)
+	    wait = interval;
+	  else if (wait < WATCH_BACKOFF * interval)
+	    wait *= 2;
+	  fflush (stdout);
+	  watch_free (prev, nprev);
+	  prev = cur;
+	  nprev = nmaps;
+	}
+
+      for (i = 0; i < nmaps; i++)
+	{
+	  free (maps[i].map);
+	  free (maps[i].master);
+	}
+      free (maps);
+
+      sleep (wait);
+    }
+
+  /* not reached */
+  return 0;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -95,12 +1009,15 @@ main (int argc, char **argv)
   char *hostname = NULL, *domainname = NULL, *master = NULL;
   int result;
   time_t order;
-  CLIENT *client;
-  bool_t clnt_res;
+  struct rpcpipe *pipe;
+  struct rpcpipe_call calls[3];
+  bool_t clnt_res = FALSE;
   int res1, res2;
   struct ypreq_nokey req;
   struct ypresp_order resp_o;
   struct ypresp_master resp_m;
+  int all = 0, lag = 0, watch = 0;
+  time_t timeout = 0, interval = 0;
 
   setlocale (LC_MESSAGES, "");
   setlocale (LC_CTYPE, "");
@@ -116,6 +1033,11 @@ main (int argc, char **argv)
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
         {"help", no_argument, NULL, '?'},
+        {"all", no_argument, NULL, '\253'},
+        {"lag", no_argument, NULL, '\252'},
+        {"timeout", required_argument, NULL, '\251'},
+        {"watch", no_argument, NULL, '\250'},
+        {"interval", required_argument, NULL, '\247'},
         {NULL, 0, NULL, '\0'}
       };
 
@@ -130,6 +1052,31 @@ main (int argc, char **argv)
 	case 'h':
 	  hostname = optarg;
 	  break;
+	case '\253':
+	  all = 1;
+	  break;
+	case '\252':
+	  lag = 1;
+	  break;
+	case '\251':
+	  timeout = atoi (optarg);
+	  if (timeout <= 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  break;
+	case '\250':
+	  watch = 1;
+	  break;
+	case '\247':
+	  interval = atoi (optarg);
+	  if (interval <= 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  break;
 	case '?':
 	  print_help ();
 	  return 0;
@@ -148,7 +1095,8 @@ main (int argc, char **argv)
   argc -= optind;
   argv += optind;
 
-  if (argc != 1)
+  if (all + lag + watch > 1 || (timeout && !lag) || (interval && !watch) ||
+      (!lag && !watch && argc != (all ? 0 : 1)))
     {
       print_error ();
       return 1;
@@ -174,11 +1122,20 @@ main (int argc, char **argv)
 
       memset (&yp3_r, 0, sizeof (struct ypbind3_resp));
 
-      /* ask local ypbind for NIS server */
-      ret = rpc_call ("localhost", YPBINDPROG, YPBINDVERS, YPBINDPROC_DOMAIN,
-		      (xdrproc_t) xdr_domainname, (caddr_t) &domainname,
-		      (xdrproc_t) xdr_ypbind3_resp, (caddr_t) &yp3_r,
-		      "udp");
+      /* ask local ypbind for NIS server, but don't try version 3
+	 again if we know it fails */
+      if (__yp_rpcvers_get ("localhost", YPBINDPROG) == YPBINDVERS_2)
+	ret = RPC_PROGVERSMISMATCH;
+      else
+	{
+	  ret = rpc_call ("localhost", YPBINDPROG, YPBINDVERS,
+			  YPBINDPROC_DOMAIN,
+			  (xdrproc_t) xdr_domainname, (caddr_t) &domainname,
+			  (xdrproc_t) xdr_ypbind3_resp, (caddr_t) &yp3_r,
+			  "udp");
+	  if (ret == RPC_PROGVERSMISMATCH)
+	    __yp_rpcvers_set ("localhost", YPBINDPROG, YPBINDVERS_2);
+	}
       if (ret == RPC_SUCCESS)
 	{
 	  if (yp3_r.ypbind_status == YPBIND_SUCC_VAL)
@@ -233,8 +1190,17 @@ main (int argc, char **argv)
 	}
     }
 
-  client = clnt_create (hostname, YPPROG, YPVERS, "udp");
-  if (client == NULL)
+  if (all)
+    return poll_all (hostname, domainname);
+  if (lag)
+    return poll_lag (hostname, domainname, argv, argc,
+		     timeout ? timeout : LAG_TIMEOUT);
+  if (watch)
+    return poll_watch (hostname, domainname, argv, argc,
+		       interval ? interval : WATCH_INTERVAL);
+
+  pipe = rpcpipe_create (hostname, YPPROG, YPVERS);
+  if (pipe == NULL)
     {
       fprintf (stderr, _("Cannot contact %s, no NIS server running or wrong protocol?\n"),
 	       hostname);
@@ -249,14 +1215,40 @@ main (int argc, char **argv)
       return 1;
    }
 
-  result = clnt_call (client, YPPROC_DOMAIN, (xdrproc_t) xdr_domainname,
-		      (caddr_t) &domainname,  (xdrproc_t) xdr_bool,
-		      (caddr_t) &clnt_res, RPCTIMEOUT);
+  /* The three calls don't depend on each other, so send them at
+     once and wait for all answers.  */
+  req.domain = domainname;
+  req.map = argv[0];
+  memset (&resp_o, '\0', sizeof (resp_o));
+  memset (&resp_m, '\0', sizeof (resp_m));
+  memset (calls, 0, sizeof (calls));
+  calls[0].proc = YPPROC_DOMAIN;
+  calls[0].inproc = (xdrproc_t) xdr_domainname;
+  calls[0].in = (caddr_t) &domainname;
+  calls[0].outproc = (xdrproc_t) xdr_bool;
+  calls[0].out = (caddr_t) &clnt_res;
+  calls[1].proc = YPPROC_ORDER;
+  calls[1].inproc = (xdrproc_t) xdr_ypreq_nokey;
+  calls[1].in = (caddr_t) &req;
+  calls[1].outproc = (xdrproc_t) xdr_ypresp_order;
+  calls[1].out = (caddr_t) &resp_o;
+  calls[2].proc = YPPROC_MASTER;
+  calls[2].inproc = (xdrproc_t) xdr_ypreq_nokey;
+  calls[2].in = (caddr_t) &req;
+  calls[2].outproc = (xdrproc_t) xdr_ypresp_master;
+  calls[2].out = (caddr_t) &resp_m;
+
+  pipe->timeout = RPCTIMEOUT;
+  if (rpcpipe_batch (pipe, calls, 3, 3) != 0)
+    calls[0].stat = RPC_CANTRECV;
+  rpcpipe_destroy (pipe);
+
+  result = calls[0].stat;
   if (result != RPC_SUCCESS)
     {
       fprintf (stderr, _("Can't create connection to %s.\n"),
 	       hostname ? hostname : "unknown");
-      clnt_perror (client, _("Reason"));
+      fprintf (stderr, "%s: %s\n", _("Reason"), clnt_sperrno (result));
       return 1;
     }
 
@@ -267,27 +1259,21 @@ main (int argc, char **argv)
       return 1;
     }
 
-  req.domain = domainname;
-  req.map = argv[0];
-  memset (&resp_o, '\0', sizeof (resp_o));
-  res1 = clnt_call (client, YPPROC_ORDER, (xdrproc_t) xdr_ypreq_nokey,
-		    (caddr_t) &req, (xdrproc_t) xdr_ypresp_order,
-		    (caddr_t) &resp_o, RPCTIMEOUT);
+  res1 = calls[1].stat;
   if (res1 == 0 && resp_o.status != YP_TRUE)
     res1 = ypprot_err (resp_o.status);
   else
     order = resp_o.ordernum;
-  xdr_free ((xdrproc_t) xdr_ypresp_order, (char *) &resp_o);
+  if (calls[1].stat == RPC_SUCCESS)
+    xdr_free ((xdrproc_t) xdr_ypresp_order, (char *) &resp_o);
 
-  memset (&resp_m, '\0', sizeof (resp_m));
-  res2 =  clnt_call (client, YPPROC_MASTER, (xdrproc_t) xdr_ypreq_nokey,
-		     (caddr_t) &req, (xdrproc_t) xdr_ypresp_master,
-		     (caddr_t) &resp_m, RPCTIMEOUT);
+  res2 = calls[2].stat;
   if (res2 == 0 && resp_m.status != YP_TRUE)
     res2 = ypprot_err (resp_m.status);
-  else
+  else if (res2 == 0)
     master = strdup (resp_m.master);
-  xdr_free ((xdrproc_t) xdr_ypresp_master, (char *) &resp_m);
+  if (calls[2].stat == RPC_SUCCESS)
+    xdr_free ((xdrproc_t) xdr_ypresp_master, (char *) &resp_m);
 
 
   if (res1 && res2)
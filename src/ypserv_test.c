@@ -25,9 +25,15 @@
 #else
 #include "lib/getopt.h"
 #endif
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
 #include <locale.h>
 #include <libintl.h>
 #include <netdb.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <netinet/in.h>
@@ -39,6 +45,7 @@
 #include <rpc/clnt_soc.h>
 #endif
 #include <rpcsvc/yp_prot.h>
+#include <rpcsvc/ypclnt.h>
 #include "lib/nicknames.h"
 #include "lib/yp_all_host.h"
 
@@ -49,14 +56,13 @@
 static struct timeval TIMEOUT = { 10, 0 };
 static char *domainname = NULL;
 static char *hostname = "localhost";
-static int do_loop = 0;
 
 /* Name and version of program.  */
 /* Print the version information.  */
 static void
 print_version (void)
 {
-  fprintf (stdout, "ypserv_test (%s) %s\n", PACKAGE, VERSION);
+  fprintf (stdout, "ypserv-bench (%s) %s\n", PACKAGE, VERSION);
   fprintf (stdout, gettext ("\
 Copyright (C) %s Thorsten Kukuk.\n\
 This is free software; see the source for copying conditions.  There is NO\n\
@@ -68,7 +74,12 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: ypserv_test [-l] [-d domain] [-h hostname] [-m map] [-u user]\n"),
+  fputs (_("Usage: ypserv-bench [-d domain] [-h hostname] [-m map] [-k key]\n"
+	   "       ypserv-bench -l [-d domain] [-h hostname] [-m map] [-k key ...]\n"
+	   "                    [--keys-from file] [--threads proc=n,...]\n"
+	   "                    [--duration sec] [--warmup sec] [--rate qps]\n"
+	   "                    [--zipf s] [--replay file]\n"
+	   "       ypserv-bench --all-streams n [-d domain] [-h hostname] [-m map]\n"),
 	 stream);
 }
 
@@ -76,16 +87,39 @@ static void
 print_help (void)
 {
   print_usage (stdout);
-  fputs (_("ypserv_test - call different NIS routines to test ypserv\n\n"),
+  fputs (_("ypserv-bench - call different NIS routines to test ypserv\n\n"),
 	 stdout);
   fputs (_("  -d domain      Use 'domain' instead of the default domain\n"),
 	 stdout);
   fputs (_("  -h hostname    Query ypserv on 'hostname' instead the current one\n"),
 	 stdout);
-  fputs (_("  -l             Run all queries in an endless loop\n"),  stdout);
-  fputs (_("  -m map         Use this existing map for tests\n"), stdout);
-  fputs (_("  -u user        Use the existing NIS user 'user' for tests\n"),
+  fputs (_("  -l             Put load on ypserv instead of testing it\n"),
 	 stdout);
+  fputs (_("  -m map         Use this existing map for the load\n"), stdout);
+  fputs (_("  -k key         Use the existing key 'key', may be given more\n"
+	   "                 than once for the load\n"), stdout);
+  fputs (_("      --keys-from file  Read the keys for the load from 'file'\n"),
+	 stdout);
+  fputs (_("      --threads proc=n,...  Threads per procedure, the procedures\n"
+	   "                 are null, domain, domain_nonack, match, first\n"
+	   "                 and next. Default is one for each\n"), stdout);
+  fputs (_("      --duration sec  Measure for 'sec' seconds, default 300\n"),
+	 stdout);
+  fputs (_("      --warmup sec  Run 'sec' seconds before measuring\n"),
+	 stdout);
+  fputs (_("      --rate qps  Send 'qps' calls per second for every procedure\n"
+	   "                 instead of sending the next call after the answer\n"),
+	 stdout);
+  fputs (_("      --zipf s    Pick the keys with a Zipf distribution with\n"
+	   "                 exponent 's', the keys are read from the map\n"
+	   "                 if none are given. first takes no key and is\n"
+	   "                 not called by default\n"), stdout);
+  fputs (_("      --replay file  Send the calls of a trace with lines\n"
+	   "                 \"time proc map [key]\" at their time, repeated\n"
+	   "                 until the end of the run. Cannot be combined\n"
+	   "                 with --rate or --zipf\n"), stdout);
+  fputs (_("      --all-streams n  Fetch the map with 1, 2, 4 ... up to 'n'\n"
+	   "                 parallel yp_all streams\n"), stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -94,7 +128,7 @@ print_help (void)
 static void
 print_error (void)
 {
-  const char *program = "ypserv_test";
+  const char *program = "ypserv-bench";
   print_usage (stderr);
   fprintf (stderr,
 	   _("Try `%s --help' or `%s --usage' for more information.\n"),
@@ -105,13 +139,13 @@ static enum clnt_stat
 ypproc_null_2(void *argp, void *clnt_res, CLIENT *clnt)
 {
   return (clnt_call(clnt, YPPROC_NULL,
-		    (xdrproc_t) xdr_void, (caddr_t) argp,
-		    (xdrproc_t) xdr_void, (caddr_t) clnt_res,
+		    (xdrproc_t) (void (*) (void)) xdr_void, (caddr_t) argp,
+		    (xdrproc_t) (void (*) (void)) xdr_void, (caddr_t) clnt_res,
 		    TIMEOUT));
 }
 
-static void *
-test_ypproc_null_2 (void *v_param __attribute__((unused)))
+static unsigned long int
+test_ypproc_null_2 (void)
 {
   CLIENT *clnt;
   unsigned long int count = 0;
@@ -119,21 +153,18 @@ test_ypproc_null_2 (void *v_param __attribute__((unused)))
   clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
   if (clnt == NULL)
     {
-      int retval = 1;
       clnt_pcreateerror (hostname);
-      pthread_exit (&retval);
+      return 1;
     }
 
-  do
+  if (ypproc_null_2 (NULL, NULL, clnt) != RPC_SUCCESS)
     {
-      if (ypproc_null_2 (NULL, NULL, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_null_2");
-	}
-    } while (do_loop);
+      count++;
+      clnt_perror (clnt, "ypproc_null_2");
+    }
 
-  return NULL;
+  clnt_destroy (clnt);
+  return count;
 }
 
 static enum clnt_stat
@@ -145,8 +176,8 @@ ypproc_domain_2 (char **argp, bool_t *clnt_res, CLIENT *clnt)
 		    TIMEOUT));
 }
 
-static void *
-test_ypproc_domain_2 (void *v_param __attribute__ ((unused)))
+static unsigned long int
+test_ypproc_domain_2 (void)
 {
   CLIENT *clnt;
   char *domain_ack = domainname;
@@ -158,55 +189,52 @@ test_ypproc_domain_2 (void *v_param __attribute__ ((unused)))
   clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
   if (clnt == NULL)
     {
-      int retval = 1;
       clnt_pcreateerror (hostname);
-      pthread_exit (&retval);
+      return 1;
     }
 
-  do
+  /* At first, try a correct domainname.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_domain_2 (&domain_ack, &result, clnt) != RPC_SUCCESS)
     {
-      /* At first, try a correct domainname.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_domain_2 (&domain_ack, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_domain_2");
-	}
-      else if (result != TRUE)
-	{
-	  count++;
-	  fprintf (stderr, "ypproc_domain_2: ypserv sends NAK instead of ACK\n");
-	}
+      count++;
+      clnt_perror (clnt, "ypproc_domain_2");
+    }
+  else if (result != TRUE)
+    {
+      count++;
+      fprintf (stderr, "ypproc_domain_2: ypserv sends NAK instead of ACK\n");
+    }
 
 
-      /* Second try: Invalid domainname.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_domain_2 (&domain_inv, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_domain_2");
-	}
-      else if (result == TRUE)
-	{
-	  count++;
-	  fprintf (stderr, "ypproc_domain_2: ypserv sends ACK instead of NAK\n");
-	}
+  /* Second try: Invalid domainname.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_domain_2 (&domain_inv, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_domain_2");
+    }
+  else if (result == TRUE)
+    {
+      count++;
+      fprintf (stderr, "ypproc_domain_2: ypserv sends ACK instead of NAK\n");
+    }
 
-      /* Third try: Not existing domainname.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_domain_2 (&domain_nak, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_domain_2");
-	}
-      else if (result == TRUE)
-	{
-	  count++;
-	  fprintf (stderr, "ypproc_domain_2: ypserv sends ACK instead of NAK\n");
-	}
-    } while (do_loop);
+  /* Third try: Not existing domainname.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_domain_2 (&domain_nak, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_domain_2");
+    }
+  else if (result == TRUE)
+    {
+      count++;
+      fprintf (stderr, "ypproc_domain_2: ypserv sends ACK instead of NAK\n");
+    }
 
-  return NULL;
+  clnt_destroy (clnt);
+  return count;
 }
 
 static enum clnt_stat
@@ -218,8 +246,8 @@ ypproc_domain_nonack_2 (char **argp, bool_t *clnt_res, CLIENT *clnt)
 		    TIMEOUT));
 }
 
-static void *
-test_ypproc_domain_nonack_2 (void *v_param __attribute__ ((unused)))
+static unsigned long int
+test_ypproc_domain_nonack_2 (void)
 {
   CLIENT *clnt;
   char *domain_ack = domainname;
@@ -231,55 +259,52 @@ test_ypproc_domain_nonack_2 (void *v_param __attribute__ ((unused)))
   clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
   if (clnt == NULL)
     {
-      int retval = 1;
       clnt_pcreateerror (hostname);
-      pthread_exit (&retval);
+      return 1;
     }
 
-  do
+  /* At first, try a correct domainname.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_domain_nonack_2 (&domain_ack, &result, clnt) != RPC_SUCCESS)
     {
-      /* At first, try a correct domainname.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_domain_nonack_2 (&domain_ack, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_domain_nonack_2");
-	}
-      else if (result != TRUE)
-	{
-	  count++;
-	  fprintf (stderr, "ypproc_domain_nonack_2: ypserv sends NAK instead of ACK\n");
-	}
+      count++;
+      clnt_perror (clnt, "ypproc_domain_nonack_2");
+    }
+  else if (result != TRUE)
+    {
+      count++;
+      fprintf (stderr, "ypproc_domain_nonack_2: ypserv sends NAK instead of ACK\n");
+    }
 
 
-      /* Second try: Invalid domainname.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_domain_nonack_2 (&domain_inv, &result, clnt) != RPC_TIMEDOUT)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_domain_nonack_2");
-	}
-      else if (result == TRUE)
-	{
-	  count++;
-	  fprintf (stderr, "ypproc_domain_nonack_2: ypserv sends ACK instead of NAK\n");
-	}
+  /* Second try: Invalid domainname.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_domain_nonack_2 (&domain_inv, &result, clnt) != RPC_TIMEDOUT)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_domain_nonack_2");
+    }
+  else if (result == TRUE)
+    {
+      count++;
+      fprintf (stderr, "ypproc_domain_nonack_2: ypserv sends ACK instead of NAK\n");
+    }
 
-      /* Third try: Not existing domainname.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_domain_nonack_2 (&domain_nak, &result, clnt) != RPC_TIMEDOUT)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_domain_nonack_2");
-	}
-      else if (result == TRUE)
-	{
-	  count++;
-	  fprintf (stderr, "ypproc_domain_nonack_2: ypserv sends ACK instead of NAK\n");
-	}
-    } while (do_loop);
+  /* Third try: Not existing domainname.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_domain_nonack_2 (&domain_nak, &result, clnt) != RPC_TIMEDOUT)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_domain_nonack_2");
+    }
+  else if (result == TRUE)
+    {
+      count++;
+      fprintf (stderr, "ypproc_domain_nonack_2: ypserv sends ACK instead of NAK\n");
+    }
 
-  return NULL;
+  clnt_destroy (clnt);
+  return count;
 }
 
 static enum clnt_stat
@@ -381,7 +406,7 @@ xdr_bytes_fake (XDR *xdrs, char **cpp, u_int *sizep, u_int maxsize)
           (void) fprintf (stderr, "%s: %s", __func__, _("out of memory\n"));
           return FALSE;
         }
-      /* fall into ... */
+      /* FALLTHROUGH */
 
     case XDR_ENCODE:
       return xdr_opaque_fake (xdrs, sp, nodesize);
@@ -410,7 +435,7 @@ xdr_ypreq_key_fake (XDR *xdrs, struct ypreq_key *objp)
 {
   if (!xdr_domainname (xdrs, &objp->domain))
     return FALSE;
-  if (!xdr_mapname (xdrs, &objp->map))
+  if (!xdr_string (xdrs, &objp->map, YPMAXMAP))
     return FALSE;
   return xdr_keydat_fake (xdrs, &objp->keydat);
 }
@@ -424,11 +449,10 @@ ypproc_match_2_fake (struct ypreq_key *argp, struct ypresp_val *clnt_res, CLIENT
 		    TIMEOUT));
 }
 
-static void *
-test_ypproc_match_2 (void *v_param)
+static unsigned long int
+test_ypproc_match_2 (char *key)
 {
   CLIENT *clnt;
-  char *key = v_param;
   struct ypreq_key request1 = {domainname, "passwd.byname", {strlen(key), key}};
   struct ypreq_key request2 = {domainname, "passwd.byname", {5, "nokey"}};
   struct ypreq_key request3 = {domainname, "passwd-byname", {strlen(key), key}};
@@ -441,107 +465,104 @@ test_ypproc_match_2 (void *v_param)
   clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
   if (clnt == NULL)
     {
-      int retval = 1;
       clnt_pcreateerror (hostname);
-      pthread_exit (&retval);
+      return 1;
     }
 
-  do
+  /* At first, try a correct query.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_match_2 (&request1, &result, clnt) != RPC_SUCCESS)
     {
-      /* At first, try a correct query.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_match_2 (&request1, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_match_2");
-	}
-      else if (result.status != YP_TRUE)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_match_2: ypserv sends %d instead of YP_TRUE\n",
-		   result.status);
-	}
+      count++;
+      clnt_perror (clnt, "ypproc_match_2");
+    }
+  else if (result.status != YP_TRUE)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_match_2: ypserv sends %d instead of YP_TRUE\n",
+	       result.status);
+    }
 
-      /* Second try: Unknown user  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_match_2 (&request2, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_match_2");
-	}
-      else if (result.status != YP_NOKEY)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_match_2: ypserv sends %d instead of YP_NOKEY\n",
-		   result.status);
-	}
+  /* Second try: Unknown user  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_match_2 (&request2, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_match_2");
+    }
+  else if (result.status != YP_NOKEY)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_match_2: ypserv sends %d instead of YP_NOKEY\n",
+	       result.status);
+    }
 
-      /* Third: Invalid map name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_match_2 (&request3, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_match_2");
-	}
-      else if (result.status != YP_NOMAP)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_match_2: ypserv sends %d instead of YP_NOMAP\n",
-		   result.status);
-	}
+  /* Third: Invalid map name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_match_2 (&request3, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_match_2");
+    }
+  else if (result.status != YP_NOMAP)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_match_2: ypserv sends %d instead of YP_NOMAP\n",
+	       result.status);
+    }
 
-      /* Fourth: Invalid domain name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_match_2 (&request4, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_match_2");
-	}
-      else if (result.status != YP_NODOM)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_match_2: ypserv sends %d instead of YP_NODOM\n",
-		   result.status);
-	}
+  /* Fourth: Invalid domain name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_match_2 (&request4, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_match_2");
+    }
+  else if (result.status != YP_NODOM)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_match_2: ypserv sends %d instead of YP_NODOM\n",
+	       result.status);
+    }
 
-      /* Fifth: Invalid key name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_match_2 (&request5, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_match_2");
-	}
-      else if (result.status != YP_BADARGS)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_match_2: ypserv sends %d instead of YP_BADARGS\n",
-		   result.status);
-	}
+  /* Fifth: Invalid key name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_match_2 (&request5, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_match_2");
+    }
+  else if (result.status != YP_BADARGS)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_match_2: ypserv sends %d instead of YP_BADARGS\n",
+	       result.status);
+    }
 
-      /* Six: Invalid size of key name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_match_2_fake (&request6, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_match_2");
-	}
-      else if (result.status != YP_BADARGS)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_match_2(6): ypserv sends %d instead of YP_BADARGS\n",
-		   result.status);
-	}
+  /* Six: Invalid size of key name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_match_2_fake (&request6, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_match_2");
+    }
+  else if (result.status != YP_BADARGS)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_match_2(6): ypserv sends %d instead of YP_BADARGS\n",
+	       result.status);
+    }
 
 
-    } while (do_loop);
 
-  return NULL;
+  clnt_destroy (clnt);
+  return count;
 }
 
 static enum clnt_stat
@@ -553,8 +574,8 @@ ypproc_first_2 (struct ypreq_nokey *argp, struct ypresp_key_val *clnt_res, CLIEN
 		    TIMEOUT));
 }
 
-static void *
-test_ypproc_first_2 (void *v_param __attribute__ ((unused)))
+static unsigned long int
+test_ypproc_first_2 (void)
 {
   CLIENT *clnt;
   struct ypreq_nokey request1 = {domainname, "passwd.byname"};
@@ -568,92 +589,89 @@ test_ypproc_first_2 (void *v_param __attribute__ ((unused)))
   clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
   if (clnt == NULL)
     {
-      int retval = 1;
       clnt_pcreateerror (hostname);
-      pthread_exit (&retval);
+      return 1;
     }
 
-  do
+  /* At first, try a correct query.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_first_2 (&request1, &result, clnt) != RPC_SUCCESS)
     {
-      /* At first, try a correct query.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_first_2 (&request1, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_first_2");
-	}
-      else if (result.status != YP_TRUE)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_first_2: ypserv sends %d instead of YP_TRUE\n",
-		   result.status);
-	}
+      count++;
+      clnt_perror (clnt, "ypproc_first_2");
+    }
+  else if (result.status != YP_TRUE)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_first_2: ypserv sends %d instead of YP_TRUE\n",
+	       result.status);
+    }
 
-      /* Second try: Invalid map name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_first_2 (&request2, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_first_2");
-	}
-      else if (result.status != YP_NOMAP)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_first_2: ypserv sends %d instead of YP_NOMAP\n",
-		   result.status);
-	}
+  /* Second try: Invalid map name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_first_2 (&request2, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_first_2");
+    }
+  else if (result.status != YP_NOMAP)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_first_2: ypserv sends %d instead of YP_NOMAP\n",
+	       result.status);
+    }
 
-      /* Third: Invalid domainname name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_first_2 (&request3, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_first_2");
-	}
-      else if (result.status != YP_NODOM)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_first_2: ypserv sends %d instead of YP_NODOM\n",
-		   result.status);
-	}
+  /* Third: Invalid domainname name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_first_2 (&request3, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_first_2");
+    }
+  else if (result.status != YP_NODOM)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_first_2: ypserv sends %d instead of YP_NODOM\n",
+	       result.status);
+    }
 
-      /* Fourth: Invalid domain name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_first_2 (&request4, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_first_2");
-	}
-      else if (result.status != YP_BADARGS)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_first_2: ypserv sends %d instead of YP_BADARGS\n",
-		   result.status);
-	}
+  /* Fourth: Invalid domain name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_first_2 (&request4, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_first_2");
+    }
+  else if (result.status != YP_BADARGS)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_first_2: ypserv sends %d instead of YP_BADARGS\n",
+	       result.status);
+    }
 
-      /* Fifth: Empty map name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_first_2 (&request5, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_first_2");
-	}
-      else if (result.status != YP_NODOM)
-	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_first_2: ypserv sends %d instead of YP_NODOM\n",
-		   result.status);
-	}
+  /* Fifth: Empty map name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_first_2 (&request5, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_first_2");
+    }
+  else if (result.status != YP_NODOM)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_first_2: ypserv sends %d instead of YP_NODOM\n",
+	       result.status);
+    }
 
 
-    } while (do_loop);
 
-  return NULL;
+  clnt_destroy (clnt);
+  return count;
 }
 
 static enum clnt_stat
@@ -665,11 +683,10 @@ ypproc_next_2 (struct ypreq_key *argp, struct ypresp_key_val *clnt_res, CLIENT *
 		    TIMEOUT));
 }
 
-static void *
-test_ypproc_next_2 (void *v_param)
+static unsigned long int
+test_ypproc_next_2 (char *key)
 {
   CLIENT *clnt;
-  char *key = v_param;
   struct ypreq_key request1 = {domainname, "passwd.byname", {strlen(key), key}};
   struct ypreq_key request2 = {domainname, "passwd.byname", {5, "nokey"}};
   struct ypreq_key request3 = {domainname, "passwd.byname", {0, NULL}};
@@ -683,131 +700,1439 @@ test_ypproc_next_2 (void *v_param)
   clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
   if (clnt == NULL)
     {
-      int retval = 1;
       clnt_pcreateerror (hostname);
-      pthread_exit (&retval);
+      return 1;
+    }
+
+  /* At first, try a correct query.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request1, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
+    }
+  else if (result.status != YP_TRUE)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_TRUE\n",
+	       result.status);
+    }
+
+  /* 2: not existing key  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request2, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
+    }
+  else if (result.status != YP_NOMORE)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_NOMORE\n",
+	       result.status);
+    }
+
+  /* 3: Invalid key  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request3, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
+    }
+  else if (result.status != YP_NOMORE)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_NOMORE\n",
+	       result.status);
+    }
+
+  /* Fourth try: Invalid map name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request4, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
+    }
+  else if (result.status != YP_NOMAP)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_NOMAP\n",
+	       result.status);
+    }
+
+  /* 5: Invalid domainname name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request5, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
+    }
+  else if (result.status != YP_NODOM)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_NODOM\n",
+	       result.status);
+    }
+
+  /* 6: Invalid domain name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request6, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
+    }
+  else if (result.status != YP_BADARGS)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_BADARGS\n",
+	       result.status);
+    }
+
+  /* 7: Empty map name.  */
+  memset (&result, 0, sizeof (result));
+  if (ypproc_next_2 (&request7, &result, clnt) != RPC_SUCCESS)
+    {
+      count++;
+      clnt_perror (clnt, "ypproc_next_2");
     }
+  else if (result.status != YP_NODOM)
+    {
+      count++;
+      fprintf (stderr,
+	       "ypproc_next_2: ypserv sends %d instead of YP_NODOM\n",
+	       result.status);
+    }
+
+
+
+  clnt_destroy (clnt);
+  return count;
+}
+
+/* The load generator: every thread calls one procedure with the map
+   and the keys given on the command line as fast as the server
+   answers, or replays the calls of this procedure from a trace.
+   Only calls after the warmup are counted.  */
+
+enum bench_proc
+{
+  BENCH_NULL,
+  BENCH_DOMAIN,
+  BENCH_DOMAIN_NONACK,
+  BENCH_MATCH,
+  BENCH_FIRST,
+  BENCH_NEXT,
+  BENCH_NPROCS
+};
+
+static const char *bench_names[BENCH_NPROCS] =
+{
+  "null", "domain", "domain_nonack", "match", "first", "next"
+};
+
+enum bench_state
+{
+  BENCH_WARMUP,
+  BENCH_RUN,
+  BENCH_STOP
+};
+
+/* Latency histogram in nanoseconds with HIST_SUB buckets for every
+   power of two, so every value is stored with less than 1% error.
+   Values below 2 * HIST_SUB are exact.  */
+#define HIST_SUB_BITS 7
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_MAXSHIFT 34
+#define HIST_SIZE ((HIST_MAXSHIFT + 2) * HIST_SUB)
+#define HIST_MAX ((2ULL * HIST_SUB << HIST_MAXSHIFT) - 1)
+
+static size_t
+hist_index (unsigned long long v)
+{
+  int shift;
+
+  if (v > HIST_MAX)
+    v = HIST_MAX;
+  if (v < 2 * HIST_SUB)
+    return v;
+  shift = 63 - __builtin_clzll (v) - HIST_SUB_BITS;
+  return (size_t) shift * HIST_SUB + (v >> shift);
+}
+
+/* The highest value which is stored in bucket idx.  */
+static unsigned long long
+hist_value (size_t idx)
+{
+  int shift;
 
-  do
+  if (idx < 2 * HIST_SUB)
+    return idx;
+  shift = idx / HIST_SUB - 1;
+  return ((unsigned long long) (idx - shift * HIST_SUB + 1) << shift) - 1;
+}
+
+/* The value below which q of all values are.  */
+static unsigned long long
+hist_percentile (const unsigned long int *hist, unsigned long int total,
+		 double q)
+{
+  unsigned long int want, seen = 0;
+  size_t i;
+
+  if (total == 0)
+    return 0;
+  want = q * total + 0.5;
+  if (want == 0)
+    want = 1;
+  for (i = 0; i < HIST_SIZE; i++)
     {
-      /* At first, try a correct query.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request1, &result, clnt) != RPC_SUCCESS)
+      seen += hist[i];
+      if (seen >= want)
+	return hist_value (i);
+    }
+  return HIST_MAX;
+}
+
+/* Counters for the answers, indexed by the NIS status - YP_VERS and
+   by the RPC error.  */
+#define BENCH_NSTATUS (YP_NOMORE - YP_VERS + 1)
+#define BENCH_NRPC 32
+#define BENCH_CACHELINE 64
+/* Longest sleep of a thread before it looks at bench_state again */
+#define BENCH_SLICE 100000000ULL
+
+struct bench_counters
+{
+  unsigned long int sent;
+  unsigned long int ok;
+  unsigned long int status[BENCH_NSTATUS];
+  unsigned long int rpc[BENCH_NRPC];
+};
+
+struct bench_worker
+{
+  /* Written by the thread, read every second by the reporter. The
+     counters of every thread have their own cache lines.  */
+  struct bench_counters cnt __attribute__ ((aligned (BENCH_CACHELINE)));
+  enum bench_proc proc;
+  unsigned int id;
+  pthread_t thread;
+  /* Time between two calls of this thread with --rate, 0 without,
+     and the time of the first call after the start.  */
+  unsigned long long interval;
+  unsigned long long offset;
+  /* Number of threads for this procedure */
+  unsigned int nthreads;
+  /* State of the random generator for --zipf */
+  unsigned long long rng;
+  /* Set if the thread could not create its client */
+  int failed;
+  /* Only written by the thread itself, read after the join */
+  unsigned long int hist[HIST_SIZE];
+};
+
+static int bench_state = BENCH_WARMUP;
+static char *bench_map = "passwd.byname";
+static char **bench_keys;
+static size_t bench_nkeys;
+/* With --zipf, key i is used with a probability proportional to
+   1 / (i + 1)^s. This is the cumulative distribution.  */
+static double *bench_cdf;
+
+/* One call of a trace, offset is the time in nanoseconds since the
+   first call of the trace and stamp the time from the file.  */
+struct bench_record
+{
+  unsigned long long offset;
+  double stamp;
+  char *map;
+  char *key;
+};
+
+/* The calls of the trace for every procedure, sorted by time. The
+   trace is sent again every bench_period nanoseconds, counted from
+   bench_epoch.  */
+static struct bench_record *bench_trace[BENCH_NPROCS];
+static size_t bench_ntrace[BENCH_NPROCS];
+static int bench_replay;
+/* Threads of bench_run which did not end yet */
+static unsigned int bench_running;
+static unsigned long long bench_period;
+static unsigned long long bench_epoch;
+
+static int
+bench_get_state (void)
+{
+  return __atomic_load_n (&bench_state, __ATOMIC_ACQUIRE);
+}
+
+static void
+bench_set_state (int state)
+{
+  __atomic_store_n (&bench_state, state, __ATOMIC_RELEASE);
+}
+
+/* Do one call. Returns 0 if the server gave the expected answer,
+   else the RPC error is in *stat or the wrong status in *status.  */
+static int
+bench_call (CLIENT *clnt, enum bench_proc proc, char *map, char *key,
+	    enum clnt_stat *stat, int *status)
+{
+  struct ypreq_nokey req_nokey = {domainname, map};
+  struct ypreq_key req_key = {domainname, map, {strlen (key), key}};
+  struct ypresp_val resp_val;
+  struct ypresp_key_val resp_key_val;
+  bool_t result = FALSE;
+
+  *status = YP_TRUE;
+  switch (proc)
+    {
+    case BENCH_NULL:
+      *stat = ypproc_null_2 (NULL, NULL, clnt);
+      break;
+    case BENCH_DOMAIN:
+      *stat = ypproc_domain_2 (&domainname, &result, clnt);
+      if (result != TRUE)
+	*status = YP_FALSE;
+      break;
+    case BENCH_DOMAIN_NONACK:
+      *stat = ypproc_domain_nonack_2 (&domainname, &result, clnt);
+      if (result != TRUE)
+	*status = YP_FALSE;
+      break;
+    case BENCH_MATCH:
+      memset (&resp_val, 0, sizeof (resp_val));
+      *stat = ypproc_match_2 (&req_key, &resp_val, clnt);
+      if (*stat == RPC_SUCCESS)
 	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
+	  *status = resp_val.status;
+	  xdr_free ((xdrproc_t) xdr_ypresp_val, (char *) &resp_val);
 	}
-      else if (result.status != YP_TRUE)
+      break;
+    case BENCH_FIRST:
+      memset (&resp_key_val, 0, sizeof (resp_key_val));
+      *stat = ypproc_first_2 (&req_nokey, &resp_key_val, clnt);
+      if (*stat == RPC_SUCCESS)
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_TRUE\n",
-		   result.status);
+	  *status = resp_key_val.status;
+	  xdr_free ((xdrproc_t) xdr_ypresp_key_val, (char *) &resp_key_val);
 	}
+      break;
+    case BENCH_NEXT:
+      memset (&resp_key_val, 0, sizeof (resp_key_val));
+      *stat = ypproc_next_2 (&req_key, &resp_key_val, clnt);
+      if (*stat == RPC_SUCCESS)
+	{
+	  *status = resp_key_val.status;
+	  xdr_free ((xdrproc_t) xdr_ypresp_key_val, (char *) &resp_key_val);
+	}
+      /* The last key of the map has no successor.  */
+      if (*status == YP_NOMORE)
+	*status = YP_TRUE;
+      break;
+    default:
+      *stat = RPC_FAILED;
+      break;
+    }
+
+  if (*stat != RPC_SUCCESS || *status != YP_TRUE)
+    return -1;
+  return 0;
+}
+
+static unsigned long long
+ts_nsec (const struct timespec *ts)
+{
+  return ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+/* Sleep until due, a CLOCK_MONOTONIC time in nanoseconds. The sleep
+   is cut into slices, so that the end of the run is noticed even if
+   due is far away with a low --rate or a gap in the trace. Returns
+   the state after the sleep.  */
+static int
+bench_sleep (unsigned long long due)
+{
+  struct timespec ts;
+  unsigned long long now;
+  int state;
 
-      /* 2: not existing key  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request2, &result, clnt) != RPC_SUCCESS)
+  while ((state = bench_get_state ()) != BENCH_STOP)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      now = ts_nsec (&ts);
+      if (now >= due)
+	break;
+      if (due - now > BENCH_SLICE)
+	now += BENCH_SLICE;
+      else
+	now = due;
+      ts.tv_sec = now / 1000000000ULL;
+      ts.tv_nsec = now % 1000000000ULL;
+      clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+  return state;
+}
+
+/* xorshift64*, good enough to pick keys and cheap enough to not
+   disturb the measurement. Returns a number in [0, 1).  */
+static double
+bench_random (struct bench_worker *w)
+{
+  w->rng ^= w->rng >> 12;
+  w->rng ^= w->rng << 25;
+  w->rng ^= w->rng >> 27;
+  return ((w->rng * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+
+static char *
+bench_pick_key (struct bench_worker *w, size_t *next)
+{
+  size_t lo = 0, hi;
+  double u;
+
+  if (bench_cdf == NULL)
+    return bench_keys[(*next)++ % bench_nkeys];
+
+  /* The first key whose cumulative probability is above u */
+  u = bench_random (w);
+  hi = bench_nkeys - 1;
+  while (lo < hi)
+    {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (bench_cdf[mid] > u)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+  return bench_keys[lo];
+}
+
+/* Count one call with the result of bench_call.  */
+static void
+bench_count (struct bench_counters *cnt, int ret, enum clnt_stat stat,
+	     int status)
+{
+  __atomic_fetch_add (&cnt->sent, 1, __ATOMIC_RELAXED);
+  if (ret == 0)
+    __atomic_fetch_add (&cnt->ok, 1, __ATOMIC_RELAXED);
+  else if (stat != RPC_SUCCESS)
+    __atomic_fetch_add (&cnt->rpc[(unsigned int) stat < BENCH_NRPC ?
+				  stat : RPC_FAILED], 1, __ATOMIC_RELAXED);
+  else
+    __atomic_fetch_add (&cnt->status[status >= YP_VERS &&
+				     status <= YP_NOMORE ?
+				     status - YP_VERS : YP_YPERR - YP_VERS],
+			1, __ATOMIC_RELAXED);
+}
+
+static void *
+bench_thread (void *v_param)
+{
+  struct bench_worker *w = v_param;
+  size_t next = w->id;
+  struct timespec ts;
+  unsigned long long due = 0;
+  CLIENT *clnt;
+  int state;
+
+  clnt = clnt_create (hostname, YPPROG, YPVERS, "udp");
+  if (clnt == NULL)
+    {
+      clnt_pcreateerror (hostname);
+      bench_count (&w->cnt, -1, rpc_createerr.cf_stat, YP_TRUE);
+      w->failed = 1;
+      __atomic_sub_fetch (&bench_running, 1, __ATOMIC_RELEASE);
+      return NULL;
+    }
+
+  if (w->interval)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      due = ts_nsec (&ts) + w->offset;
+    }
+
+  while ((state = bench_get_state ()) != BENCH_STOP)
+    {
+      unsigned long long start;
+      enum clnt_stat stat;
+      char *map, *key;
+      int ret, status;
+
+      if (bench_replay)
 	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
+	  size_t n = bench_ntrace[w->proc];
+	  const struct bench_record *r = &bench_trace[w->proc][next % n];
+
+	  /* The threads of one procedure take turns in the trace.  */
+	  due = bench_epoch + (next / n) * bench_period + r->offset;
+	  next += w->nthreads;
+	  map = r->map;
+	  key = r->key;
 	}
-      else if (result.status != YP_NOMORE)
+      else
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_NOMORE\n",
-		   result.status);
+	  map = bench_map;
+	  key = bench_pick_key (w, &next);
 	}
 
-      /* 3: Invalid key  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request3, &result, clnt) != RPC_SUCCESS)
+      if (w->interval || bench_replay)
 	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
+	  /* Open loop: the latency counts from the time the call was
+	     due, so a slow answer also delays the following calls
+	     in the statistic, not only in reality.  */
+	  if ((state = bench_sleep (due)) == BENCH_STOP)
+	    break;
+	  start = due;
+	  due += w->interval;
 	}
-      else if (result.status != YP_NOMORE)
+      else
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_NOMORE\n",
-		   result.status);
+	  clock_gettime (CLOCK_MONOTONIC, &ts);
+	  start = ts_nsec (&ts);
 	}
 
-      /* Fourth try: Invalid map name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request4, &result, clnt) != RPC_SUCCESS)
+      ret = bench_call (clnt, w->proc, map, key, &stat, &status);
+
+      if (state == BENCH_RUN && bench_get_state () == BENCH_RUN)
 	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
+	  clock_gettime (CLOCK_MONOTONIC, &ts);
+	  w->hist[hist_index (ts_nsec (&ts) - start)]++;
+	  bench_count (&w->cnt, ret, stat, status);
 	}
-      else if (result.status != YP_NOMAP)
+    }
+
+  clnt_destroy (clnt);
+  __atomic_sub_fetch (&bench_running, 1, __ATOMIC_RELEASE);
+  return NULL;
+}
+
+/* Parse "proc=threads,...", procedures which are not named get no
+   threads.  */
+static int
+bench_parse_threads (char *arg, unsigned int *threads)
+{
+  char *tok, *saveptr;
+  int i;
+
+  for (i = 0; i < BENCH_NPROCS; i++)
+    threads[i] = 0;
+
+  for (tok = strtok_r (arg, ",", &saveptr); tok;
+       tok = strtok_r (NULL, ",", &saveptr))
+    {
+      char *val = strchr (tok, '=');
+      char *ep;
+      long n;
+
+      if (val == NULL)
+	return -1;
+      *val++ = '\0';
+      n = strtol (val, &ep, 10);
+      if (*val == '\0' || *ep != '\0' || n < 0 || n > 4096)
+	return -1;
+      for (i = 0; i < BENCH_NPROCS; i++)
+	if (strcmp (tok, bench_names[i]) == 0)
+	  break;
+      if (i == BENCH_NPROCS)
+	return -1;
+      threads[i] = n;
+    }
+  return 0;
+}
+
+/* A decimal number between 1 and max. strtoul alone would accept
+   "-1" as a huge value.  */
+static int
+bench_parse_num (const char *arg, unsigned long int max,
+		 unsigned long int *num)
+{
+  char *ep;
+
+  if (*arg < '0' || *arg > '9')
+    return -1;
+  errno = 0;
+  *num = strtoul (arg, &ep, 10);
+  if (*ep != '\0' || errno != 0 || *num == 0 || *num > max)
+    return -1;
+  return 0;
+}
+
+static int
+bench_add_key (const char *key)
+{
+  char **tmp = realloc (bench_keys, (bench_nkeys + 1) * sizeof (char *));
+
+  if (tmp == NULL)
+    return -1;
+  bench_keys = tmp;
+  if ((bench_keys[bench_nkeys] = strdup (key)) == NULL)
+    return -1;
+  bench_nkeys++;
+  return 0;
+}
+
+/* One key per line, empty lines are ignored.  */
+static int
+bench_read_keys (const char *file)
+{
+  char *line = NULL;
+  size_t linesize = 0;
+  ssize_t n;
+  FILE *fp;
+
+  if (strcmp (file, "-") == 0)
+    fp = stdin;
+  else if ((fp = fopen (file, "r")) == NULL)
+    {
+      fprintf (stderr, _("ypserv-bench: can't open %s: %m\n"), file);
+      return -1;
+    }
+
+  while ((n = getline (&line, &linesize, fp)) > 0)
+    {
+      if (line[n - 1] == '\n')
+	line[--n] = '\0';
+      if (n == 0)
+	continue;
+      if (bench_add_key (line) != 0)
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_NOMAP\n",
-		   result.status);
+	  fputs (_("ypserv-bench: Out of memory\n"), stderr);
+	  free (line);
+	  if (fp != stdin)
+	    fclose (fp);
+	  return -1;
 	}
+    }
+  free (line);
+  if (fp != stdin)
+    fclose (fp);
+  return 0;
+}
+
+struct bench_fetch
+{
+  int failed;
+};
+
+static int
+bench_fetch_key (int instatus, char *inkey, int inkeylen,
+		 char *inval __attribute__ ((unused)),
+		 int invallen __attribute__ ((unused)), char *indata)
+{
+  struct bench_fetch *f = (struct bench_fetch *) indata;
+  char *key;
+
+  if (instatus != YP_TRUE)
+    return 1;
+
+  /* Some maps store the keys with a trailing NUL byte.  */
+  while (inkeylen > 0 && inkey[inkeylen - 1] == '\0')
+    inkeylen--;
+  if ((key = strndup (inkey, inkeylen)) == NULL || bench_add_key (key) != 0)
+    {
+      free (key);
+      f->failed = 1;
+      return 1;
+    }
+  free (key);
+  return 0;
+}
+
+/* Use all keys of the map for the load, in the order in which
+   ypserv sends them.  */
+static int
+bench_fetch_keys (void)
+{
+  struct ypall_callback ypcb;
+  struct bench_fetch f = {0};
+  int err;
+
+  ypcb.foreach = bench_fetch_key;
+  ypcb.data = (char *) &f;
+  err = yp_all_host (domainname, bench_map, &ypcb, hostname);
+  if (f.failed)
+    {
+      fputs (_("ypserv-bench: Out of memory\n"), stderr);
+      return -1;
+    }
+  if (err != YPERR_SUCCESS)
+    {
+      fprintf (stderr, _("ypserv-bench: can't get the keys of %s: %s\n"),
+	       bench_map, yperr_string (err));
+      return -1;
+    }
+  if (bench_nkeys == 0)
+    {
+      fprintf (stderr, _("ypserv-bench: %s has no keys\n"), bench_map);
+      return -1;
+    }
+  return 0;
+}
+
+static int
+bench_zipf (double s)
+{
+  double sum = 0;
+  size_t i;
+
+  bench_cdf = malloc (bench_nkeys * sizeof (double));
+  if (bench_cdf == NULL)
+    {
+      fputs (_("ypserv-bench: Out of memory\n"), stderr);
+      return -1;
+    }
+  for (i = 0; i < bench_nkeys; i++)
+    {
+      sum += pow (i + 1, -s);
+      bench_cdf[i] = sum;
+    }
+  for (i = 0; i < bench_nkeys; i++)
+    bench_cdf[i] /= sum;
+  return 0;
+}
+
+static int
+bench_record_cmp (const void *a, const void *b)
+{
+  const struct bench_record *ra = a, *rb = b;
+
+  if (ra->offset < rb->offset)
+    return -1;
+  return ra->offset > rb->offset;
+}
+
+/* Read a trace with one call per line: "time proc map [key]", the
+   time in seconds, the rest of the line is the key. Lines starting
+   with '#' are comments.  */
+static int
+bench_read_trace (const char *file)
+{
+  char *line = NULL;
+  size_t linesize = 0, lineno = 0, total = 0, n[BENCH_NPROCS] = {0};
+  double first = 0, last = 0;
+  ssize_t len;
+  FILE *fp;
+  int p;
+
+  if (strcmp (file, "-") == 0)
+    fp = stdin;
+  else if ((fp = fopen (file, "r")) == NULL)
+    {
+      fprintf (stderr, "ypserv-bench: %s: %m\n", file);
+      return -1;
+    }
 
-      /* 5: Invalid domainname name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request5, &result, clnt) != RPC_SUCCESS)
+  while ((len = getline (&line, &linesize, fp)) > 0)
+    {
+      char proc[32], map[YPMAXMAP + 1];
+      struct bench_record *tmp, *r;
+      double stamp;
+      int used;
+
+      lineno++;
+      if (line[len - 1] == '\n')
+	line[--len] = '\0';
+      if (line[0] == '#' || line[strspn (line, " \t")] == '\0')
+	continue;
+      if (sscanf (line, "%lf %31s %64s %n", &stamp, proc, map, &used) < 3)
 	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
+	  fprintf (stderr, _("ypserv-bench: %s:%lu: syntax error\n"), file,
+		   (unsigned long int) lineno);
+	  goto error;
 	}
-      else if (result.status != YP_NODOM)
+      for (p = 0; p < BENCH_NPROCS; p++)
+	if (strcmp (proc, bench_names[p]) == 0)
+	  break;
+      if (p == BENCH_NPROCS)
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_NODOM\n",
-		   result.status);
+	  fprintf (stderr, _("ypserv-bench: %s:%lu: unknown procedure %s\n"),
+		   file, (unsigned long int) lineno, proc);
+	  goto error;
 	}
 
-      /* 6: Invalid domain name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request6, &result, clnt) != RPC_SUCCESS)
-	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
-	}
-      else if (result.status != YP_BADARGS)
+      if (total == 0 || stamp < first)
+	first = stamp;
+      if (total == 0 || stamp > last)
+	last = stamp;
+      total++;
+
+      tmp = realloc (bench_trace[p], (n[p] + 1) * sizeof (*tmp));
+      if (tmp == NULL)
+	goto nomem;
+      bench_trace[p] = tmp;
+      r = &tmp[n[p]];
+      r->stamp = stamp;
+      r->map = strdup (map);
+      r->key = strdup (line + used);
+      if (r->map == NULL || r->key == NULL)
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_BADARGS\n",
-		   result.status);
+	  free (r->map);
+	  free (r->key);
+	  goto nomem;
 	}
+      n[p]++;
+    }
+  free (line);
+  line = NULL;
+  if (fp != stdin)
+    fclose (fp);
+  fp = NULL;
 
-      /* 7: Empty map name.  */
-      memset (&result, 0, sizeof (result));
-      if (ypproc_next_2 (&request7, &result, clnt) != RPC_SUCCESS)
+  if (total == 0)
+    {
+      fprintf (stderr, _("ypserv-bench: %s: no calls in the trace\n"), file);
+      return -1;
+    }
+
+  for (p = 0; p < BENCH_NPROCS; p++)
+    {
+      size_t i;
+
+      for (i = 0; i < n[p]; i++)
+	bench_trace[p][i].offset = (bench_trace[p][i].stamp - first) * 1e9;
+      qsort (bench_trace[p], n[p], sizeof (struct bench_record),
+	     bench_record_cmp);
+      bench_ntrace[p] = n[p];
+    }
+
+  /* Keep the average distance between the last call of the trace
+     and the first one of the next round.  */
+  bench_period = (last - first) * 1e9;
+  if (total > 1)
+    bench_period += bench_period / (total - 1);
+  if (bench_period == 0)
+    bench_period = 1000000000ULL;
+  bench_replay = 1;
+  return 0;
+
+ nomem:
+  fputs (_("ypserv-bench: Out of memory\n"), stderr);
+ error:
+  free (line);
+  if (fp != NULL && fp != stdin)
+    fclose (fp);
+  return -1;
+}
+
+/* Sleep for secs seconds, returns 1 if a signal in sigs came
+   first.  */
+static int
+bench_wait (const sigset_t *sigs, unsigned int secs)
+{
+  struct timespec end, now, ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  end.tv_sec += secs;
+
+  while (1)
+    {
+      clock_gettime (CLOCK_MONOTONIC, &now);
+      if (now.tv_sec > end.tv_sec ||
+	  (now.tv_sec == end.tv_sec && now.tv_nsec >= end.tv_nsec))
+	return 0;
+      ts.tv_sec = end.tv_sec - now.tv_sec;
+      ts.tv_nsec = end.tv_nsec - now.tv_nsec;
+      if (ts.tv_nsec < 0)
 	{
-	  count++;
-	  clnt_perror (clnt, "ypproc_next_2");
+	  ts.tv_sec--;
+	  ts.tv_nsec += 1000000000;
 	}
-      else if (result.status != YP_NODOM)
+      if (sigtimedwait (sigs, NULL, &ts) > 0)
+	return 1;
+    }
+}
+
+/* Wait until all threads of the run ended. A thread may still wait
+   for the answer of a call, a SIGINT or SIGTERM in the meantime ends
+   the program at once.  */
+static void
+bench_wait_threads (const sigset_t *sigs)
+{
+  struct timespec ts = { 0, BENCH_SLICE };
+  int sig;
+
+  while (__atomic_load_n (&bench_running, __ATOMIC_ACQUIRE) > 0)
+    if ((sig = sigtimedwait (sigs, NULL, &ts)) > 0)
+      {
+	signal (sig, SIG_DFL);
+	pthread_sigmask (SIG_UNBLOCK, sigs, NULL);
+	raise (sig);
+      }
+}
+
+/* Names for the summary, so that scripts can parse it.  */
+static const char *
+bench_status_name (int status)
+{
+  switch (status)
+    {
+    case YP_TRUE:
+      return "true";
+    case YP_NOMORE:
+      return "nomore";
+    case YP_FALSE:
+      return "false";
+    case YP_NOMAP:
+      return "nomap";
+    case YP_NODOM:
+      return "nodom";
+    case YP_NOKEY:
+      return "nokey";
+    case YP_BADOP:
+      return "badop";
+    case YP_BADDB:
+      return "baddb";
+    case YP_YPERR:
+      return "yperr";
+    case YP_BADARGS:
+      return "badargs";
+    case YP_VERS:
+      return "vers";
+    default:
+      return NULL;
+    }
+}
+
+static const char *
+bench_rpc_name (enum clnt_stat stat)
+{
+  switch (stat)
+    {
+    case RPC_CANTENCODEARGS:
+      return "cantencodeargs";
+    case RPC_CANTDECODERES:
+      return "cantdecoderes";
+    case RPC_CANTSEND:
+      return "cantsend";
+    case RPC_CANTRECV:
+      return "cantrecv";
+    case RPC_TIMEDOUT:
+      return "timedout";
+    case RPC_VERSMISMATCH:
+      return "versmismatch";
+    case RPC_AUTHERROR:
+      return "autherror";
+    case RPC_PROGUNAVAIL:
+      return "progunavail";
+    case RPC_PROGVERSMISMATCH:
+      return "progversmismatch";
+    case RPC_PROCUNAVAIL:
+      return "procunavail";
+    case RPC_CANTDECODEARGS:
+      return "cantdecodeargs";
+    case RPC_SYSTEMERROR:
+      return "systemerror";
+    case RPC_UNKNOWNHOST:
+      return "unknownhost";
+    case RPC_UNKNOWNPROTO:
+      return "unknownproto";
+    case RPC_PMAPFAILURE:
+      return "pmapfailure";
+    case RPC_PROGNOTREGISTERED:
+      return "prognotregistered";
+    case RPC_FAILED:
+      return "failed";
+    default:
+      return NULL;
+    }
+}
+
+/* Add the counters of all threads of procedure proc, or of all
+   threads if proc is BENCH_NPROCS. The threads are still running
+   while the reporter calls this, so the sums are only nearly
+   consistent.  */
+static void
+bench_sum (const struct bench_worker *workers, size_t nworkers, int proc,
+	   struct bench_counters *sum)
+{
+  size_t i, j;
+
+  memset (sum, 0, sizeof (struct bench_counters));
+  for (i = 0; i < nworkers; i++)
+    {
+      const struct bench_counters *c = &workers[i].cnt;
+
+      if (proc != BENCH_NPROCS && workers[i].proc != (enum bench_proc) proc)
+	continue;
+      sum->sent += __atomic_load_n (&c->sent, __ATOMIC_RELAXED);
+      sum->ok += __atomic_load_n (&c->ok, __ATOMIC_RELAXED);
+      for (j = 0; j < BENCH_NSTATUS; j++)
+	sum->status[j] += __atomic_load_n (&c->status[j], __ATOMIC_RELAXED);
+      for (j = 0; j < BENCH_NRPC; j++)
+	sum->rpc[j] += __atomic_load_n (&c->rpc[j], __ATOMIC_RELAXED);
+    }
+}
+
+struct bench_report
+{
+  struct bench_worker *workers;
+  /* Only threads which are already running */
+  size_t nworkers;
+};
+
+/* Print the calls and errors of the last second to stderr, so that
+   a saturated server shows up while the run is still going on.  */
+static void *
+bench_reporter (void *v_param)
+{
+  struct bench_report *r = v_param;
+  struct bench_counters sum;
+  unsigned long int last_sent = 0, last_ok = 0, elapsed = 0;
+  struct timespec due;
+  int state;
+
+  clock_gettime (CLOCK_MONOTONIC, &due);
+  while ((state = bench_get_state ()) != BENCH_STOP)
+    {
+      unsigned long int sent, errors;
+
+      due.tv_sec++;
+      bench_sleep (ts_nsec (&due));
+      if (state != BENCH_RUN || bench_get_state () != BENCH_RUN)
+	continue;
+
+      bench_sum (r->workers, r->nworkers, BENCH_NPROCS, &sum);
+      sent = sum.sent - last_sent;
+      errors = sent - (sum.ok - last_ok);
+      elapsed++;
+      fprintf (stderr, "[%4lus] %10lu calls/s %10lu ok/s %6.2f%% errors\n",
+	       elapsed, sent, sum.ok - last_ok,
+	       sent ? 100.0 * errors / sent : 0.0);
+      last_sent = sum.sent;
+      last_ok = sum.ok;
+    }
+
+  return NULL;
+}
+
+/* Print one line "key=value ..." for procedure proc, or the total if
+   proc is BENCH_NPROCS. Returns the number of errors.  */
+static unsigned long int
+bench_summary (const struct bench_worker *workers, size_t nworkers, int proc,
+	       unsigned int nthreads, double secs, unsigned long int *hist)
+{
+  struct bench_counters sum;
+  unsigned long int timed = 0;
+  size_t i, j;
+
+  bench_sum (workers, nworkers, proc, &sum);
+  memset (hist, 0, HIST_SIZE * sizeof (unsigned long int));
+  for (i = 0; i < nworkers; i++)
+    if (proc == BENCH_NPROCS || workers[i].proc == (enum bench_proc) proc)
+      for (j = 0; j < HIST_SIZE; j++)
+	hist[j] += workers[i].hist[j];
+  /* Threads without a client count as errors, but have no latency */
+  for (j = 0; j < HIST_SIZE; j++)
+    timed += hist[j];
+
+  printf ("proc=%s threads=%u seconds=%.3f sent=%lu ok=%lu errors=%lu"
+	  " calls_per_sec=%.1f ok_per_sec=%.1f"
+	  " p50_ms=%.3f p99_ms=%.3f p999_ms=%.3f",
+	  proc == BENCH_NPROCS ? "total" : bench_names[proc], nthreads, secs,
+	  sum.sent, sum.ok, sum.sent - sum.ok,
+	  secs > 0 ? sum.sent / secs : 0.0, secs > 0 ? sum.ok / secs : 0.0,
+	  hist_percentile (hist, timed, 0.50) / 1e6,
+	  hist_percentile (hist, timed, 0.99) / 1e6,
+	  hist_percentile (hist, timed, 0.999) / 1e6);
+  for (j = 0; j < BENCH_NSTATUS; j++)
+    if (sum.status[j])
+      {
+	const char *name = bench_status_name (j + YP_VERS);
+
+	if (name)
+	  printf (" status_%s=%lu", name, sum.status[j]);
+	else
+	  printf (" status_%d=%lu", (int) j + YP_VERS, sum.status[j]);
+      }
+  for (j = 0; j < BENCH_NRPC; j++)
+    if (sum.rpc[j])
+      {
+	const char *name = bench_rpc_name (j);
+
+	if (name)
+	  printf (" rpc_%s=%lu", name, sum.rpc[j]);
+	else
+	  printf (" rpc_%d=%lu", (int) j, sum.rpc[j]);
+      }
+  putchar ('\n');
+
+  return sum.sent - sum.ok;
+}
+
+/* Start the threads, stop them after the warmup and duration or at
+   SIGINT/SIGTERM, and print the calls per procedure.  */
+static int
+bench_run (unsigned int *threads, unsigned int warmup, unsigned int duration,
+	   unsigned long int rate)
+{
+  struct bench_worker *workers;
+  struct bench_report report;
+  struct timespec start, end;
+  unsigned long int *hist;
+  pthread_t reporter;
+  sigset_t sigs;
+  size_t nworkers = 0, started = 0, i;
+  double secs;
+  int p, ret = 0, have_reporter;
+
+  for (p = 0; p < BENCH_NPROCS; p++)
+    {
+      /* With a trace, only the procedures in it are called.  */
+      if (bench_replay && bench_ntrace[p] == 0)
+	threads[p] = 0;
+      else if (bench_replay && threads[p] == 0)
+	fprintf (stderr, _("ypserv-bench: no threads for the %lu %s calls "
+			   "in the trace\n"),
+		 (unsigned long int) bench_ntrace[p], bench_names[p]);
+      nworkers += threads[p];
+    }
+  if (nworkers == 0)
+    {
+      fputs (_("ypserv-bench: no threads to start\n"), stderr);
+      return 1;
+    }
+  if (posix_memalign ((void **) &workers, BENCH_CACHELINE,
+		      nworkers * sizeof (struct bench_worker)) != 0)
+    workers = NULL;
+  else
+    memset (workers, 0, nworkers * sizeof (struct bench_worker));
+  hist = calloc (HIST_SIZE, sizeof (unsigned long int));
+  if (workers == NULL || hist == NULL)
+    {
+      free (workers);
+      free (hist);
+      fputs (_("ypserv-bench: Out of memory\n"), stderr);
+      return 1;
+    }
+
+  /* The trace starts 100ms from now, when all threads are
+     running.  */
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  bench_epoch = ts_nsec (&start) + 100000000ULL;
+
+  /* Only the main thread waits for the signals.  */
+  sigemptyset (&sigs);
+  sigaddset (&sigs, SIGINT);
+  sigaddset (&sigs, SIGTERM);
+  pthread_sigmask (SIG_BLOCK, &sigs, NULL);
+
+  for (p = 0; p < BENCH_NPROCS && ret == 0; p++)
+    {
+      unsigned int t;
+
+      for (t = 0; t < threads[p]; t++)
 	{
-	  count++;
-	  fprintf (stderr,
-		   "ypproc_next_2: ypserv sends %d instead of YP_NODOM\n",
-		   result.status);
+	  struct bench_worker *w = &workers[started];
+
+	  w->proc = p;
+	  w->id = t;
+	  w->nthreads = threads[p];
+	  w->rng = (started + 1) * 0x9E3779B97F4A7C15ULL;
+	  /* The rate is for the procedure, not for every thread, and
+	     the threads of one procedure take turns.  */
+	  if (rate && !bench_replay)
+	    {
+	      w->interval = 1000000000ULL * threads[p] / rate;
+	      w->offset = 1000000000ULL * t / rate;
+	    }
+	  __atomic_add_fetch (&bench_running, 1, __ATOMIC_RELAXED);
+	  if (pthread_create (&w->thread, NULL, bench_thread, w) != 0)
+	    {
+	      __atomic_sub_fetch (&bench_running, 1, __ATOMIC_RELAXED);
+	      fprintf (stderr, _("ypserv-bench: can't create thread: %m\n"));
+	      ret = 1;
+	      break;
+	    }
+	  started++;
 	}
+    }
 
+  report.workers = workers;
+  report.nworkers = started;
+  have_reporter = (ret == 0 &&
+		   pthread_create (&reporter, NULL, bench_reporter,
+				   &report) == 0);
+
+  if (ret == 0 && !bench_wait (&sigs, warmup))
+    {
+      bench_set_state (BENCH_RUN);
+      clock_gettime (CLOCK_MONOTONIC, &start);
+      bench_wait (&sigs, duration);
+    }
+  else
+    clock_gettime (CLOCK_MONOTONIC, &start);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  bench_set_state (BENCH_STOP);
 
-    } while (do_loop);
+  bench_wait_threads (&sigs);
+  for (i = 0; i < started; i++)
+    {
+      pthread_join (workers[i].thread, NULL);
+      if (workers[i].failed)
+	ret = 1;
+    }
+  if (have_reporter)
+    pthread_join (reporter, NULL);
+
+  secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  for (p = 0; p < BENCH_NPROCS; p++)
+    if (threads[p])
+      bench_summary (workers, started, p, threads[p], secs, hist);
+  if (bench_summary (workers, started, BENCH_NPROCS, started, secs, hist))
+    ret = 1;
+
+  free (hist);
+  free (workers);
+  return ret;
+}
+
+
+/* Stress test for YPPROC_ALL: n threads fetch the whole map at the
+   same time, each over its own TCP connection, like all clients do
+   after a map was pushed.  */
+#define STREAM_MAX 4096
+
+/* The streams start together, not while the other threads are still
+   created.  */
+struct stream_gate
+{
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  /* 0 while the threads are created, 1 to start, -1 to give up */
+  int go;
+};
+
+struct stream_worker
+{
+  pthread_t thread;
+  struct stream_gate *gate;
+  /* Nanoseconds: start before connecting, first record and end */
+  unsigned long long start;
+  unsigned long long first;
+  unsigned long long end;
+  unsigned long int records;
+  unsigned long long bytes;
+  int err;
+};
+
+static int
+stream_record (int instatus, char *inkey __attribute__ ((unused)),
+	       int inkeylen, char *inval __attribute__ ((unused)),
+	       int invallen, char *indata)
+{
+  struct stream_worker *w = (struct stream_worker *) indata;
+
+  if (instatus != YP_TRUE)
+    return 1;
+
+  if (w->records == 0)
+    {
+      struct timespec ts;
+
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      w->first = ts_nsec (&ts);
+    }
+  w->records++;
+  w->bytes += inkeylen + invallen;
+  return 0;
+}
 
+static void *
+stream_thread (void *v_param)
+{
+  struct stream_worker *w = v_param;
+  struct ypall_callback ypcb;
+  struct timespec ts;
+  CLIENT *clnt;
+
+  int go;
+
+  ypcb.foreach = stream_record;
+  ypcb.data = (char *) w;
+
+  pthread_mutex_lock (&w->gate->lock);
+  while ((go = w->gate->go) == 0)
+    pthread_cond_wait (&w->gate->cond, &w->gate->lock);
+  pthread_mutex_unlock (&w->gate->lock);
+  if (go < 0)
+    return NULL;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  w->start = ts_nsec (&ts);
+
+  clnt = clnt_create (hostname, YPPROG, YPVERS, "tcp");
+  if (clnt == NULL)
+    w->err = YPERR_PMAP;
+  else
+    {
+      w->err = yp_all_clnt (clnt, domainname, bench_map, &ypcb);
+      clnt_destroy (clnt);
+    }
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  w->end = ts_nsec (&ts);
   return NULL;
 }
 
+static int
+stream_cmp (const void *a, const void *b)
+{
+  double da = *(const double *) a, db = *(const double *) b;
+
+  return (da > db) - (da < db);
+}
+
+/* Run n streams at once and print one line "key=value ..." with the
+   throughput of the server and of the single streams. Returns the
+   number of failed streams, or -1 if the threads could not be
+   started.  */
+static int
+stream_step (unsigned int n)
+{
+  struct stream_worker *workers;
+  struct stream_gate gate;
+  unsigned long long first_start = 0, last_end = 0, bytes = 0;
+  unsigned long int records = 0;
+  double *rate, *first, secs;
+  unsigned int i, started, ok = 0;
+  int err = YPERR_SUCCESS;
+
+  workers = calloc (n, sizeof (struct stream_worker));
+  rate = calloc (n, sizeof (double));
+  first = calloc (n, sizeof (double));
+  if (workers == NULL || rate == NULL || first == NULL)
+    {
+      free (workers);
+      free (rate);
+      free (first);
+      fputs (_("ypserv-bench: Out of memory\n"), stderr);
+      return -1;
+    }
+
+  gate.go = 0;
+  if ((errno = pthread_mutex_init (&gate.lock, NULL)) != 0)
+    goto fail;
+  if ((errno = pthread_cond_init (&gate.cond, NULL)) != 0)
+    {
+      pthread_mutex_destroy (&gate.lock);
+      goto fail;
+    }
+  for (started = 0; started < n; started++)
+    {
+      workers[started].gate = &gate;
+      if ((errno = pthread_create (&workers[started].thread, NULL,
+				   stream_thread, &workers[started])) != 0)
+	break;
+    }
+  if (started < n)
+    fprintf (stderr, _("ypserv-bench: can't create thread: %m\n"));
+
+  pthread_mutex_lock (&gate.lock);
+  gate.go = started < n ? -1 : 1;
+  pthread_cond_broadcast (&gate.cond);
+  pthread_mutex_unlock (&gate.lock);
+  for (i = 0; i < started; i++)
+    pthread_join (workers[i].thread, NULL);
+  pthread_cond_destroy (&gate.cond);
+  pthread_mutex_destroy (&gate.lock);
+  if (started < n)
+    goto out;
+
+  for (i = 0; i < n; i++)
+    {
+      struct stream_worker *w = &workers[i];
+
+      if (i == 0 || w->start < first_start)
+	first_start = w->start;
+      if (w->end > last_end)
+	last_end = w->end;
+      records += w->records;
+      bytes += w->bytes;
+      if (w->err != YPERR_SUCCESS)
+	{
+	  err = w->err;
+	  continue;
+	}
+      rate[ok] = w->end > w->start ?
+	w->bytes / ((w->end - w->start) / 1e9) / 1e6 : 0.0;
+      first[ok] = w->records ? (w->first - w->start) / 1e6 : 0.0;
+      ok++;
+    }
+  qsort (rate, ok, sizeof (double), stream_cmp);
+  qsort (first, ok, sizeof (double), stream_cmp);
+
+  secs = (last_end - first_start) / 1e9;
+  printf ("streams=%u ok=%u failed=%u records=%lu mbytes=%.3f seconds=%.3f"
+	  " mb_per_sec=%.3f", n, ok, n - ok, records, bytes / 1e6, secs,
+	  secs > 0 ? bytes / secs / 1e6 : 0.0);
+  if (ok)
+    printf (" stream_mb_per_sec_min=%.3f stream_mb_per_sec_p50=%.3f"
+	    " stream_mb_per_sec_max=%.3f first_record_ms_p50=%.3f"
+	    " first_record_ms_max=%.3f", rate[0], rate[ok / 2],
+	    rate[ok - 1], first[ok / 2], first[ok - 1]);
+  putchar ('\n');
+  fflush (stdout);
+  if (ok < n)
+    fprintf (stderr, _("ypserv-bench: %u of %u streams failed: %s\n"),
+	     n - ok, n, yperr_string (err));
+
+  free (workers);
+  free (rate);
+  free (first);
+  return n - ok;
+
+ fail:
+  fprintf (stderr, "ypserv-bench: %m\n");
+ out:
+  free (workers);
+  free (rate);
+  free (first);
+  return -1;
+}
+
+/* Double the number of streams up to max, so the point where the
+   server saturates shows up in the aggregated throughput.  */
+static int
+stream_run (unsigned int max)
+{
+  unsigned int n = 1;
+  int ret = 0;
+
+  while (1)
+    {
+      int res = stream_step (n);
+
+      if (res < 0)
+	return 1;
+      if (res > 0)
+	ret = 1;
+      if (n >= max)
+	break;
+      n = n * 2 > max ? max : n * 2;
+    }
+  return ret;
+}
 
 int
 main (int argc, char **argv)
 {
   char *domain = NULL;
-  char *map = "passwd.byname";
-  char *key = "nobody";
+  char *keyfile = NULL;
+  unsigned int threads[BENCH_NPROCS] = {1, 1, 1, 1, 1, 1};
+  unsigned int duration = 5 * 60, warmup = 0;
+  unsigned long int rate = 0, failed = 0;
+  char *tracefile = NULL;
+  unsigned int streams = 0;
+  double zipf = 0;
+  int do_bench = 0, threads_set = 0;
 
   setlocale (LC_MESSAGES, "");
   setlocale (LC_CTYPE, "");
@@ -818,11 +2143,21 @@ main (int argc, char **argv)
     {
       int c;
       int option_index = 0;
+      unsigned long int num;
+      char *ep;
       static struct option long_options[] =
       {
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
         {"help", no_argument, NULL, '?'},
+        {"threads", required_argument, NULL, '\253'},
+        {"duration", required_argument, NULL, '\252'},
+        {"warmup", required_argument, NULL, '\251'},
+        {"keys-from", required_argument, NULL, '\250'},
+        {"rate", required_argument, NULL, '\247'},
+        {"zipf", required_argument, NULL, '\246'},
+        {"replay", required_argument, NULL, '\245'},
+        {"all-streams", required_argument, NULL, '\244'},
         {NULL, 0, NULL, '\0'}
       };
 
@@ -838,13 +2173,83 @@ main (int argc, char **argv)
 	  hostname = optarg;
 	  break;
 	case 'l':
-	  do_loop = 1;
+	  do_bench = 1;
 	  break;
 	case 'm':
-	  map = optarg;
+	  bench_map = optarg;
 	  break;
 	case 'k':
-	  key = optarg;
+	  if (bench_add_key (optarg) != 0)
+	    {
+	      fputs (_("ypserv-bench: Out of memory\n"), stderr);
+	      return 1;
+	    }
+	  break;
+	case '\253':
+	  if (bench_parse_threads (optarg, threads) != 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  threads_set = 1;
+	  do_bench = 1;
+	  break;
+	case '\252':
+	  if (bench_parse_num (optarg, UINT_MAX, &num) != 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  duration = num;
+	  do_bench = 1;
+	  break;
+	case '\251':
+	  /* A warmup of 0 is the same as none.  */
+	  if (strcmp (optarg, "0") == 0)
+	    warmup = 0;
+	  else if (bench_parse_num (optarg, UINT_MAX, &num) != 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  else
+	    warmup = num;
+	  do_bench = 1;
+	  break;
+	case '\250':
+	  keyfile = optarg;
+	  do_bench = 1;
+	  break;
+	case '\247':
+	  if (bench_parse_num (optarg, ULONG_MAX, &rate) != 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  do_bench = 1;
+	  break;
+	case '\246':
+	  errno = 0;
+	  zipf = strtod (optarg, &ep);
+	  if (ep == optarg || *ep != '\0' || errno != 0 || !isfinite (zipf)
+	      || zipf <= 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  do_bench = 1;
+	  break;
+	case '\245':
+	  tracefile = optarg;
+	  do_bench = 1;
+	  break;
+	case '\244':
+	  if (bench_parse_num (optarg, STREAM_MAX, &num) != 0)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  streams = num;
 	  break;
 	case '?':
 	  print_help ();
@@ -883,27 +2288,57 @@ main (int argc, char **argv)
   if (domainname == NULL)
     domainname = domain;
 
-  if (do_loop)
-    {
-      pthread_t thread1, thread2, thread3, thread4, thread5, thread6;
+  if (streams)
+    return stream_run (streams);
 
-      pthread_create (&thread1, NULL, &test_ypproc_null_2, NULL);
-      pthread_create (&thread2, NULL, &test_ypproc_domain_2, NULL);
-      pthread_create (&thread3, NULL, &test_ypproc_domain_nonack_2, NULL);
-      pthread_create (&thread4, NULL, &test_ypproc_match_2, key);
-      pthread_create (&thread5, NULL, &test_ypproc_first_2, NULL);
-      pthread_create (&thread6, NULL, &test_ypproc_next_2, key);
-      sleep (5*60);
+  /* The trace has its own times and keys, and first takes no key,
+     these options would be ignored.  */
+  if (tracefile && (rate || zipf > 0))
+    {
+      fprintf (stderr, _("ypserv-bench: --replay cannot be used with %s\n"),
+	       rate ? "--rate" : "--zipf");
+      return 1;
     }
-  else
+  if (zipf > 0)
     {
-      test_ypproc_null_2 (NULL);
-      test_ypproc_domain_2 (NULL);
-      test_ypproc_domain_nonack_2 (NULL);
-      test_ypproc_match_2 (key);
-      test_ypproc_first_2 (NULL);
-      test_ypproc_next_2 (key);
+      if (threads_set && threads[BENCH_FIRST] > 0)
+	{
+	  fputs (_("ypserv-bench: --zipf cannot be used with first "
+		   "threads\n"), stderr);
+	  return 1;
+	}
+      threads[BENCH_FIRST] = 0;
     }
 
+  if (keyfile && bench_read_keys (keyfile) != 0)
+    return 1;
+  if (tracefile && bench_read_trace (tracefile) != 0)
+    return 1;
+  if (zipf > 0 && bench_nkeys == 0 && bench_fetch_keys () != 0)
+    return 1;
+  if (bench_nkeys == 0 && bench_add_key ("nobody") != 0)
+    {
+      fputs (_("ypserv-bench: Out of memory\n"), stderr);
+      return 1;
+    }
+
+  if (zipf > 0 && bench_zipf (zipf) != 0)
+    return 1;
+
+  if (do_bench)
+    return bench_run (threads, warmup, duration, rate);
+
+  failed += test_ypproc_null_2 ();
+  failed += test_ypproc_domain_2 ();
+  failed += test_ypproc_domain_nonack_2 ();
+  failed += test_ypproc_match_2 (bench_keys[0]);
+  failed += test_ypproc_first_2 ();
+  failed += test_ypproc_next_2 (bench_keys[0]);
+
+  if (failed)
+    {
+      fprintf (stderr, _("%lu tests failed\n"), failed);
+      return 1;
+    }
   return 0;
 }
@@ -25,11 +25,14 @@
 #include <getopt.h>
 #include <locale.h>
 #include <libintl.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <rpc/rpc.h>
+#include <rpc/pmap_prot.h>
 #include <rpcsvc/ypclnt.h>
 #include <rpcsvc/yp_prot.h>
 
@@ -40,6 +43,8 @@
 #endif
 
 #include "internal.h"
+#include "rpcpipe.h"
+#include "yp_hostaddr.h"
 
 #ifndef _
 #define _(String) gettext (String)
@@ -62,7 +67,10 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: ypset [-d domain] [-h hostname] server\n"), stream);
+  fputs (_("Usage: ypset [-d domain] [-h hostname] server\n"
+	   "       ypset [-d domain] [-h hostname] --fastest server ...\n"
+	   "       ypset [-d domain] --hosts file [--fastest] server ...\n"),
+	 stream);
 }
 
 static void
@@ -74,6 +82,10 @@ print_help (void)
   fputs (_("  -d domain      Use 'domain' instead of the default domain\n"),
 	 stdout);
   fputs (_("  -h hostname    Set ypbind's binding on 'hostname'\n"), stdout);
+  fputs (_("      --fastest  Bind to the server which answers fastest\n"),
+	 stdout);
+  fputs (_("      --hosts file  Set the binding on all hosts in 'file'\n"),
+	 stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -90,45 +102,79 @@ print_error (void)
 	   program, program);
 }
 
-/* bind to a special host and set a new NIS server */
+/* Fill in the version 2 binding for new_server. Returns -1 if
+   new_server can not be used.  */
 static int
-bind_tohost_v2 (const char *hostname, char *domainname, char *new_server)
+setdom_v2 (char *domainname, char *new_server, struct ypbind2_setdom *ypsd)
 {
-  struct ypbind2_setdom ypsd;
-  const struct timeval tv = {15, 0};
   struct hostent *hp;
-  CLIENT *client;
   int port;
   int16_t port16;
-  int res;
   struct in_addr server_addr;
+  char netid[32], uaddr[128];
+  unsigned int a[4], p[2];
+
+  memset (ypsd, '\0', sizeof (*ypsd));
 
-  if ((port = htons (getrpcport (new_server, YPPROG, YPPROC_NULL, IPPROTO_UDP)))
-      == 0)
+  /* The universal address of udp is "a.b.c.d.port-high.port-low" */
+  if (__yp_bindcache_get (new_server, netid, sizeof (netid), uaddr,
+			  sizeof (uaddr)) == 0 && strcmp (netid, "udp") == 0 &&
+      sscanf (uaddr, "%u.%u.%u.%u.%u.%u", &a[0], &a[1], &a[2], &a[3],
+	      &p[0], &p[1]) == 6 && (a[0] | a[1] | a[2] | a[3]) < 256 &&
+      (p[0] | p[1]) < 256)
     {
-      fprintf (stderr, _("%s not running ypserv.\n"), new_server);
-      exit (1);
+      server_addr.s_addr = htonl ((a[0] << 24) | (a[1] << 16) |
+				  (a[2] << 8) | a[3]);
+      memcpy (&ypsd->ypsetdom_binding.ypbind_binding_addr,
+	      &server_addr.s_addr, sizeof (server_addr.s_addr));
+      port = htons ((p[0] << 8) | p[1]);
     }
+  else
+    {
+      if ((port = htons (getrpcport (new_server, YPPROG, YPPROC_NULL,
+				     IPPROTO_UDP))) == 0)
+	{
+	  fprintf (stderr, _("%s not running ypserv.\n"), new_server);
+	  return -1;
+	}
 
-  memset (&ypsd, '\0', sizeof (ypsd));
+      if ((hp = gethostbyname2 (new_server, AF_INET)) != NULL)
+	memcpy (&server_addr.s_addr, hp->h_addr_list[0],
+		sizeof (server_addr.s_addr));
+      else if (inet_aton (new_server, &server_addr) == 0)
+	{
+	  fprintf (stderr, _("can't find IPv4 address for %s\n"),
+		   new_server);
+	  return -1;
+	}
+      memcpy (&ypsd->ypsetdom_binding.ypbind_binding_addr,
+	      &server_addr.s_addr, sizeof (server_addr.s_addr));
 
-  if ((hp = gethostbyname2 (new_server, AF_INET)) != NULL)
-    memcpy (&ypsd.ypsetdom_binding.ypbind_binding_addr, hp->h_addr_list[0],
-	    sizeof (ypsd.ypsetdom_binding.ypbind_binding_addr));
-  else if (inet_aton (new_server, &server_addr) == 0)
-    {
-      fprintf (stderr, _("can't find IPv4 address for %s\n"), new_server);
-      exit (1);
+      snprintf (uaddr, sizeof (uaddr), "%s.%u.%u", inet_ntoa (server_addr),
+		ntohs (port) >> 8, ntohs (port) & 0xff);
+      __yp_bindcache_set (new_server, "udp", uaddr);
     }
-  else
-    memcpy (&ypsd.ypsetdom_binding.ypbind_binding_addr, &server_addr.s_addr,
-	    sizeof (server_addr.s_addr));
 
-  ypsd.ypsetdom_domain = domainname;
+  ypsd->ypsetdom_domain = domainname;
   port16 = port;
-  memcpy (&ypsd.ypsetdom_binding.ypbind_binding_port, &port16,
-	  sizeof (ypsd.ypsetdom_binding.ypbind_binding_port));
-  ypsd.ypsetdom_vers = YPVERS;
+  memcpy (&ypsd->ypsetdom_binding.ypbind_binding_port, &port16,
+	  sizeof (ypsd->ypsetdom_binding.ypbind_binding_port));
+  ypsd->ypsetdom_vers = YPVERS;
+
+  return 0;
+}
+
+/* bind to a special host and set a new NIS server */
+static int
+bind_tohost_v2 (const char *hostname, char *domainname, char *new_server)
+{
+  struct ypbind2_setdom ypsd;
+  const struct timeval tv = {15, 0};
+  CLIENT *client;
+  int res;
+
+  if (setdom_v2 (domainname, new_server, &ypsd) != 0)
+    exit (1);
 
   client = clnt_create (hostname, YPBINDPROG, YPBINDVERS_2, "udp");
   if (client == NULL)
@@ -142,7 +188,7 @@ bind_tohost_v2 (const char *hostname, char *domainname, char *new_server)
 
   res = clnt_call (client, YPBINDPROC_SETDOM,
 		   (xdrproc_t) xdr_ypbind2_setdom, (caddr_t) &ypsd,
-		   (xdrproc_t) xdr_void, NULL, tv);
+		   (xdrproc_t) (void (*) (void)) xdr_void, NULL, tv);
   if (res)
     {
       fprintf (stderr, _("Cannot ypset for domain %s on host %s.\n"),
@@ -184,7 +230,7 @@ bind_tohost_v3 (const char *hostname, char *domainname, char *new_server)
 
   res = clnt_call (client, YPBINDPROC_SETDOM,
 		   (xdrproc_t) xdr_ypbind3_setdom, (caddr_t) &ypsd,
-		   (xdrproc_t) xdr_void, NULL, tv);
+		   (xdrproc_t) (void (*) (void)) xdr_void, NULL, tv);
   if (res)
     {
       fprintf (stderr, _("Cannot ypset for domain %s on host %s.\n"),
@@ -198,10 +244,515 @@ bind_tohost_v3 (const char *hostname, char *domainname, char *new_server)
 }
 #endif
 
+/* Round trips measured per server with --fastest, and the time
+   one of them may take.  */
+#define PROBE_SAMPLES 5
+#define PROBE_TIMEOUT 2
+
+/* A server which --fastest compares */
+struct probe
+{
+  const char *name;
+  struct yp_hostaddr ha;
+  /* Samples done, -1 while asking the portmapper */
+  int state;
+  bool_t domain_ok;
+  struct timeval sent;
+  double rtt[PROBE_SAMPLES];
+  /* Why the server can not be used, or NULL */
+  const char *error;
+};
+
+struct probe_run
+{
+  char *domain;
+  struct probe *probes;
+  size_t nprobes;
+  size_t next;
+  size_t *queue;
+  size_t nqueue;
+  struct timeval timeout;
+};
+
+static int
+probe_next (void *data, struct rpcpipe_call *call)
+{
+  struct probe_run *run = data;
+  struct probe *p;
+
+  while (1)
+    {
+      if (run->nqueue > 0)
+	{
+	  p = &run->probes[run->queue[--run->nqueue]];
+	  break;
+	}
+      if (run->next >= run->nprobes)
+	return 0;
+
+      p = &run->probes[run->next++];
+      if (p->ha.error)
+	{
+	  p->error = yp_hostaddr_error (&p->ha);
+	  continue;
+	}
+      /* The lookup counts against the time for the first call.  */
+      if (!yp_hostaddr_left (&p->ha, &run->timeout, &call->timeout))
+	{
+	  p->error = clnt_sperrno (RPC_TIMEDOUT);
+	  continue;
+	}
+      p->state = -1;
+      yp_hostaddr_getport (&p->ha, YPPROG, YPVERS, call);
+      call->data = p;
+      return 1;
+    }
+
+  call->addr = (struct sockaddr *) &p->ha.addr;
+  call->addrlen = p->ha.addrlen;
+  call->data = p;
+
+  /* Alternate between the bare round trip and a call which
+     ypserv has to answer itself.  */
+  yp_hostaddr_setport (&p->ha, p->ha.port);
+  call->prog = YPPROG;
+  call->vers = YPVERS;
+  if (p->state % 2 == 0)
+    {
+      call->proc = YPPROC_DOMAIN;
+      call->inproc = (xdrproc_t) xdr_domainname;
+      call->in = (caddr_t) &run->domain;
+      call->outproc = (xdrproc_t) xdr_bool;
+      call->out = (caddr_t) &p->domain_ok;
+    }
+  else
+    {
+      call->proc = YPPROC_NULL;
+      call->inproc = (xdrproc_t) (void (*) (void)) xdr_void;
+      call->outproc = (xdrproc_t) (void (*) (void)) xdr_void;
+    }
+  gettimeofday (&p->sent, NULL);
+
+  return 1;
+}
+
+static void
+probe_done (void *data, struct rpcpipe_call *call)
+{
+  struct probe_run *run = data;
+  struct probe *p = call->data;
+  struct timeval now, diff;
+
+  gettimeofday (&now, NULL);
+
+  if (call->stat != RPC_SUCCESS)
+    {
+      p->error = clnt_sperrno (call->stat);
+      return;
+    }
+
+  if (p->state < 0)
+    {
+      if (p->ha.port == 0 || p->ha.port > 0xffff)
+	{
+	  p->error = _("not running ypserv");
+	  return;
+	}
+    }
+  else
+    {
+      if (call->proc == YPPROC_DOMAIN && !p->domain_ok)
+	{
+	  p->error = yperr_string (YPERR_DOMAIN);
+	  return;
+	}
+      timersub (&now, &p->sent, &diff);
+      p->rtt[p->state] = diff.tv_sec * 1000.0 + diff.tv_usec / 1000.0;
+    }
+
+  if (++p->state < PROBE_SAMPLES)
+    run->queue[run->nqueue++] = p - run->probes;
+}
+
+static int
+cmp_double (const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* Ask all servers at the same time, one round trip after the other
+   for every server. Returns the server with the smallest median
+   round trip time, or NULL if none answered.  */
+static char *
+find_fastest (char *domainname, char **servers, int nservers)
+{
+  struct probe_run run;
+  struct yp_hostaddr **ha;
+  struct rpcpipe *pipe;
+  double best = 0;
+  char *fastest = NULL;
+  int i;
+
+  memset (&run, 0, sizeof (run));
+  run.domain = domainname;
+  run.nprobes = nservers;
+  run.timeout.tv_sec = PROBE_TIMEOUT;
+  run.probes = calloc (nservers, sizeof (struct probe));
+  run.queue = calloc (nservers, sizeof (size_t));
+  ha = calloc (nservers, sizeof (struct yp_hostaddr *));
+  if (run.probes == NULL || run.queue == NULL || ha == NULL)
+    {
+      fprintf (stderr, "ypset: %s\n", yperr_string (YPERR_RESRC));
+      free (run.probes);
+      free (run.queue);
+      free (ha);
+      return NULL;
+    }
+  for (i = 0; i < nservers; i++)
+    {
+      run.probes[i].name = servers[i];
+      run.probes[i].ha.name = servers[i];
+      ha[i] = &run.probes[i].ha;
+    }
+  /* Look up all servers first, a slow lookup in probe_next would
+     delay the calls in flight and falsify their round trip.  */
+  yp_resolve_hosts (ha, nservers, &run.timeout);
+  free (ha);
+
+  pipe = rpcpipe_open ();
+  if (pipe == NULL)
+    {
+      fprintf (stderr, "ypset: %s\n", clnt_spcreateerror ("rpcpipe"));
+      free (run.probes);
+      free (run.queue);
+      return NULL;
+    }
+  pipe->timeout.tv_sec = PROBE_TIMEOUT;
+  pipe->timeout.tv_usec = 0;
+  rpcpipe_run (pipe, nservers, probe_next, probe_done, &run);
+  rpcpipe_destroy (pipe);
+
+  for (i = 0; i < nservers; i++)
+    {
+      struct probe *p = &run.probes[i];
+      double median;
+
+      if (p->error == NULL && p->state < PROBE_SAMPLES)
+	p->error = clnt_sperrno (RPC_CANTRECV);
+      if (p->error != NULL)
+	{
+	  fprintf (stderr, "ypset: %s: %s\n", p->name, p->error);
+	  continue;
+	}
+
+      qsort (p->rtt, PROBE_SAMPLES, sizeof (double), cmp_double);
+      median = p->rtt[PROBE_SAMPLES / 2];
+      fprintf (stderr, "%-24s %.3f ms\n", p->name, median);
+      if (fastest == NULL || median < best)
+	{
+	  fastest = servers[i];
+	  best = median;
+	}
+    }
+
+  free (run.probes);
+  free (run.queue);
+
+  return fastest;
+}
+
+/* SETDOM calls in flight with --hosts, and the time a host has to
+   answer, the same as for a single host.  */
+#define REBIND_WINDOW 256
+#define REBIND_TIMEOUT 15
+
+enum rebind_state
+{
+  REBIND_PMAP,
+  REBIND_V3,
+  REBIND_V2
+};
+
+struct rebind_host
+{
+  char *name;
+  enum rebind_state state;
+  struct yp_hostaddr ha;
+};
+
+struct rebind
+{
+  struct rebind_host *hosts;
+  size_t nhosts;
+  size_t next;
+  /* Hosts waiting for the next call */
+  size_t *queue;
+  size_t nqueue;
+  char *server;
+  struct timeval timeout;
+#if defined(HAVE_YPBIND3)
+  struct ypbind3_setdom sd3;
+#endif
+  /* NULL if the server has no version 2 binding */
+  struct ypbind2_setdom *sd2;
+  int failed;
+};
+
+static void
+rebind_finish (struct rebind *rb, struct rebind_host *h, const char *error)
+{
+  if (error)
+    {
+      fprintf (stderr, "ypset: %s: %s\n", h->name, error);
+      rb->failed = 1;
+    }
+  else
+    printf ("%s %s\n", h->name, rb->server);
+  fflush (stdout);
+}
+
+static int
+rebind_next (void *data, struct rpcpipe_call *call)
+{
+  struct rebind *rb = data;
+  struct rebind_host *h;
+
+  while (1)
+    {
+      if (rb->nqueue > 0)
+	{
+	  h = &rb->hosts[rb->queue[--rb->nqueue]];
+	  break;
+	}
+      if (rb->next >= rb->nhosts)
+	return 0;
+
+      h = &rb->hosts[rb->next++];
+      if (h->ha.error)
+	{
+	  rebind_finish (rb, h, yp_hostaddr_error (&h->ha));
+	  continue;
+	}
+      /* The lookup counts against the time for the first call.  */
+      if (!yp_hostaddr_left (&h->ha, &rb->timeout, &call->timeout))
+	{
+	  rebind_finish (rb, h, clnt_sperrno (RPC_TIMEDOUT));
+	  continue;
+	}
+      h->state = REBIND_PMAP;
+      break;
+    }
+
+  yp_hostaddr_setport (&h->ha, h->ha.port);
+  call->addr = (struct sockaddr *) &h->ha.addr;
+  call->addrlen = h->ha.addrlen;
+  call->data = h;
+
+  switch (h->state)
+    {
+    case REBIND_PMAP:
+      /* ypbind registers version 2 in every case */
+      yp_hostaddr_getport (&h->ha, YPBINDPROG, 2, call);
+      break;
+#if defined(HAVE_YPBIND3)
+    case REBIND_V3:
+      call->prog = YPBINDPROG;
+      call->vers = YPBINDVERS;
+      call->proc = YPBINDPROC_SETDOM;
+      call->inproc = (xdrproc_t) xdr_ypbind3_setdom;
+      call->in = (caddr_t) &rb->sd3;
+      call->outproc = (xdrproc_t) (void (*) (void)) xdr_void;
+      break;
+#endif
+    default:
+      call->prog = YPBINDPROG;
+      call->vers = YPBINDVERS_2;
+      call->proc = YPBINDPROC_SETDOM;
+      call->inproc = (xdrproc_t) xdr_ypbind2_setdom;
+      call->in = (caddr_t) rb->sd2;
+      call->outproc = (xdrproc_t) (void (*) (void)) xdr_void;
+      break;
+    }
+
+  return 1;
+}
+
+static void
+rebind_done (void *data, struct rpcpipe_call *call)
+{
+  struct rebind *rb = data;
+  struct rebind_host *h = call->data;
+
+  if (call->stat != RPC_SUCCESS)
+    {
+#if defined(HAVE_YPBIND3)
+      /* if the V3 protocol does not work, try v2 as fallback */
+      if (h->state == REBIND_V3 && call->stat == RPC_PROGVERSMISMATCH)
+	{
+	  __yp_rpcvers_set (h->name, YPBINDPROG, YPBINDVERS_2);
+	  if (rb->sd2 == NULL)
+	    {
+	      rebind_finish (rb, h, clnt_sperrno (call->stat));
+	      return;
+	    }
+	  h->state = REBIND_V2;
+	  rb->queue[rb->nqueue++] = h - rb->hosts;
+	  return;
+	}
+#endif
+      rebind_finish (rb, h, clnt_sperrno (call->stat));
+      return;
+    }
+
+  if (h->state != REBIND_PMAP)
+    {
+      rebind_finish (rb, h, NULL);
+      return;
+    }
+
+  if (h->ha.port == 0 || h->ha.port > 0xffff)
+    {
+      rebind_finish (rb, h, yperr_string (YPERR_YPBIND));
+      return;
+    }
+#if defined(HAVE_YPBIND3)
+  if (rb->sd3.ypsetdom_bindinfo != NULL &&
+      (rb->sd2 == NULL ||
+       __yp_rpcvers_get (h->name, YPBINDPROG) != YPBINDVERS_2))
+    h->state = REBIND_V3;
+  else
+#endif
+    h->state = REBIND_V2;
+  rb->queue[rb->nqueue++] = h - rb->hosts;
+}
+
+/* Set the binding of all hosts in file to new_server. The binding is
+   looked up only once and the SETDOM calls go to all hosts at the
+   same time.  */
+static int
+rebind_hosts (const char *file, char *domainname, char *new_server)
+{
+  struct rebind rb;
+  struct ypbind2_setdom sd2;
+  struct yp_hostaddr **ha;
+  struct rpcpipe *pipe;
+  char *line = NULL;
+  size_t linesize = 0, size = 0, i;
+  FILE *fp;
+
+  memset (&rb, 0, sizeof (rb));
+  rb.server = new_server;
+
+  if (strcmp (file, "-") == 0)
+    fp = stdin;
+  else if ((fp = fopen (file, "r")) == NULL)
+    {
+      fprintf (stderr, _("ypset: can't open %s: %m\n"), file);
+      return 1;
+    }
+
+  while (getline (&line, &linesize, fp) >= 0)
+    {
+      char *p = line + strspn (line, " \t");
+
+      p[strcspn (p, " \t\r\n#")] = '\0';
+      if (*p == '\0')
+	continue;
+      if (rb.nhosts == size)
+	{
+	  struct rebind_host *tmp;
+
+	  size = size ? 2 * size : 256;
+	  tmp = realloc (rb.hosts, size * sizeof (struct rebind_host));
+	  if (tmp == NULL)
+	    {
+	      fputs (_("ypset: Out of memory\n"), stderr);
+	      return 1;
+	    }
+	  rb.hosts = tmp;
+	}
+      memset (&rb.hosts[rb.nhosts], 0, sizeof (struct rebind_host));
+      if ((rb.hosts[rb.nhosts].name = strdup (p)) == NULL)
+	{
+	  fputs (_("ypset: Out of memory\n"), stderr);
+	  return 1;
+	}
+      rb.nhosts++;
+    }
+  free (line);
+  if (fp != stdin)
+    fclose (fp);
+
+  /* The binding is the same for every host.  */
+#if defined(HAVE_YPBIND3)
+  rb.sd3.ypsetdom_domain = domainname;
+  rb.sd3.ypsetdom_bindinfo = __host2ypbind3_binding (new_server);
+#endif
+  if (setdom_v2 (domainname, new_server, &sd2) == 0)
+    rb.sd2 = &sd2;
+#if defined(HAVE_YPBIND3)
+  if (rb.sd3.ypsetdom_bindinfo == NULL && rb.sd2 == NULL)
+#else
+  if (rb.sd2 == NULL)
+#endif
+    return 1;
+
+  rb.queue = calloc (rb.nhosts + 1, sizeof (size_t));
+  ha = calloc (rb.nhosts + 1, sizeof (struct yp_hostaddr *));
+  pipe = rpcpipe_open ();
+  if (rb.queue == NULL || ha == NULL || pipe == NULL)
+    {
+      fprintf (stderr, "ypset: %s\n", yperr_string (YPERR_RESRC));
+      return 1;
+    }
+  /* ypbind ignores SETDOM from other ports, but still answers.  */
+  if (rpcpipe_bindresvport (pipe) != 0)
+    {
+      fprintf (stderr, _("ypset: can't bind to a reserved port: %m\n"));
+      rpcpipe_destroy (pipe);
+      return 1;
+    }
+
+  /* Look up all hosts first, a slow lookup in rebind_next would
+     stop all calls in flight.  */
+  rb.timeout.tv_sec = REBIND_TIMEOUT;
+  for (i = 0; i < rb.nhosts; i++)
+    {
+      rb.hosts[i].ha.name = rb.hosts[i].name;
+      ha[i] = &rb.hosts[i].ha;
+    }
+  yp_resolve_hosts (ha, rb.nhosts, &rb.timeout);
+  free (ha);
+
+  /* ypbind accepts SETDOM only with unix credentials */
+  AUTH_DESTROY (pipe->auth);
+  pipe->auth = authunix_create_default ();
+  pipe->timeout = rb.timeout;
+
+  if (rpcpipe_run (pipe, REBIND_WINDOW, rebind_next, rebind_done, &rb) != 0)
+    rb.failed = 1;
+  rpcpipe_destroy (pipe);
+
+#if defined(HAVE_YPBIND3)
+  if (rb.sd3.ypsetdom_bindinfo != NULL)
+    __ypbind3_binding_free (rb.sd3.ypsetdom_bindinfo);
+#endif
+  for (i = 0; i < rb.nhosts; i++)
+    free (rb.hosts[i].name);
+  free (rb.hosts);
+  free (rb.queue);
+
+  return rb.failed;
+}
+
 int
 main (int argc, char **argv)
 {
   char *hostname = NULL, *domainname = NULL;
+  char *hostsfile = NULL;
+  int fastest = 0;
 
   setlocale (LC_MESSAGES, "");
   setlocale (LC_CTYPE, "");
@@ -217,6 +768,8 @@ main (int argc, char **argv)
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
         {"help", no_argument, NULL, '?'},
+        {"fastest", no_argument, NULL, '\253'},
+        {"hosts", required_argument, NULL, '\252'},
         {NULL, 0, NULL, '\0'}
       };
 
@@ -231,6 +784,12 @@ main (int argc, char **argv)
 	case 'h':
 	  hostname = optarg;
 	  break;
+	case '\253':
+	  fastest = 1;
+	  break;
+	case '\252':
+	  hostsfile = optarg;
+	  break;
 	case '?':
 	  print_help ();
 	  return 0;
@@ -249,7 +808,7 @@ main (int argc, char **argv)
   argc -= optind;
   argv += optind;
 
-  if (argc != 1)
+  if ((fastest ? argc < 1 : argc != 1) || (hostname && hostsfile))
     {
       print_error ();
       return 1;
@@ -273,6 +832,19 @@ main (int argc, char **argv)
       if (hostname == NULL)
 	hostname = "localhost";
 
+      if (fastest)
+	{
+	  new_server = find_fastest (domainname, argv, argc);
+	  if (new_server == NULL)
+	    {
+	      fprintf (stderr, _("No server answered.\n"));
+	      return 1;
+	    }
+	}
+
+      if (hostsfile)
+	return rebind_hosts (hostsfile, domainname, new_server);
+
 #if defined(HAVE_YPBIND3)
       if (bind_tohost_v3 (hostname, domainname, new_server))
 #endif
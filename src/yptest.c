@@ -20,6 +20,7 @@
 #include "config.h"
 #endif
 
+#include <errno.h>
 #include <getopt.h>
 #include <locale.h>
 #include <libintl.h>
@@ -33,6 +34,7 @@
 #include <rpcsvc/yp_prot.h>
 #include "lib/nicknames.h"
 #include "lib/yp_all_host.h"
+#include "lib/outbuf.h"
 
 #ifndef _
 #define _(String) gettext (String)
@@ -48,6 +50,8 @@
 extern int yp_maplist (const char *, struct ypmaplist **);
 
 static int be_quiet = 0;
+static struct outbuf output;
+static int write_error;
 
 /* Name and version of program.  */
 /* Print the version information.  */
@@ -66,7 +70,7 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: yptest [-q] [-d domain] [-h hostname] [-m map] [-u user]\n"),
+  fputs (_("Usage: yptest [-q] [-d domain] [-h hostname] [-m map] [-u user] [--stats]\n"),
 	 stream);
 }
 
@@ -85,6 +89,8 @@ print_help (void)
 	 stdout);
   fputs (_("  -q             Be quiet, don't print messages\n"),
 	 stdout);
+  fputs (_("      --stats    Print number of records and bytes per second of yp_all\n"),
+	 stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -235,6 +241,8 @@ static int
 print_data (int status, char *inkey, int inkeylen, char *inval,
             int invallen, char *indata __attribute__ ((unused)))
 {
+  const char *key = NULL;
+
   if (status != YP_TRUE)
     return status;
 
@@ -242,18 +250,28 @@ print_data (int status, char *inkey, int inkeylen, char *inval,
     {
       if (inkey[inkeylen - 1] == '\0')
         --inkeylen;
-      if (!be_quiet)
-	fprintf (stdout, "%*.*s ", inkeylen, inkeylen, inkey);
+      key = inkey;
     }
   if (invallen > 0)
     {
       if (inval[invallen -1] == '\0')
         --invallen;
-      if (!be_quiet)
-	fprintf (stdout, "%*.*s\n", invallen, invallen, inval);
     }
-  else if (!be_quiet)
-    fputs ("\n", stdout);
+  else
+    invallen = 0;
+
+  if (be_quiet)
+    {
+      output.records++;
+      output.bytes += (key ? inkeylen + 1 : 0) + invallen + 1;
+      return 0;
+    }
+
+  if (outbuf_put (&output, key, inkeylen, inval, invallen) != 0)
+    {
+      write_error = errno;
+      return 1;
+    }
 
   return 0;
 }
@@ -271,6 +289,7 @@ main (int argc, char **argv)
   char *Key2;
   int      ValLen;
   int status;
+  int stats = 0;
   unsigned int order;
   struct ypall_callback Callback;
   struct ypmaplist *ypml, *y;
@@ -288,6 +307,7 @@ main (int argc, char **argv)
       {
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
+        {"stats", no_argument, NULL, '\253'},
         {"help", no_argument, NULL, '?'},
         {NULL, 0, NULL, '\0'}
       };
@@ -312,6 +332,9 @@ main (int argc, char **argv)
 	case 'q':
 	  be_quiet = 1;
 	  break;
+	case '\253':
+	  stats = 1;
+	  break;
 	case '?':
 	  print_help ();
 	  return 0;
@@ -519,10 +542,39 @@ main (int argc, char **argv)
   if (!be_quiet)
     printf("\nTest 9: yp_all\n");
   Callback.foreach = print_data;
+  Callback.data = NULL;
+  /* print_data writes to the file descriptor directly */
+  fflush (stdout);
+  if (outbuf_init (&output, STDOUT_FILENO, OUTBUF_SIZE) != 0)
+    {
+      fprintf (stderr, "yptest: %s\n", strerror (errno));
+      return 1;
+    }
   if (hostname)
     status = yp_all_host (domainname, map, &Callback, hostname);
   else
     status = yp_all(domainname, map, &Callback);
+  if (outbuf_flush (&output) != 0 && write_error == 0)
+    write_error = errno;
+  if (write_error != 0)
+    {
+      fprintf (stderr, _("yptest: write error: %s\n"),
+	       strerror (write_error));
+      outbuf_destroy (&output);
+      return 1;
+    }
+  if (stats)
+    {
+      double secs = outbuf_elapsed (&output);
+
+      if (secs <= 0)
+	secs = 1e-9;
+      fprintf (stderr,
+	       _("%llu records, %llu bytes in %.3f s (%.0f records/s, %.0f bytes/s)\n"),
+	       output.records, output.bytes, secs,
+	       output.records / secs, output.bytes / secs);
+    }
+  outbuf_destroy (&output);
   switch (status)
     {
     case YPERR_SUCCESS:
@@ -30,9 +30,21 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <string.h>
+#include <sys/time.h>
 #include <rpc/rpc.h>
+#include <rpc/pmap_prot.h>
 #include <rpcsvc/yp_prot.h>
 #include "lib/nicknames.h"
+#include "lib/internal.h"
+#include "lib/rpcpipe.h"
+#include "lib/yp_hostaddr.h"
+
+/* Number of YPPROC_MASTER queries in flight for -m without map */
+#define MASTER_WINDOW 32
+/* Number of hosts asked at the same time with --hosts, and the
+   default time a host has to answer */
+#define SCAN_WINDOW 256
+#define SCAN_TIMEOUT 5
 
 /* from ypbind-mt/ypbind.h */
 #define YPBINDPROC_OLDDOMAIN 1
@@ -67,7 +79,8 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
 static void
 print_usage (FILE *stream)
 {
-  fputs (_("Usage: ypwhich [-d domain] [[-t] -m [mname]|[-Vn] hostname] | -x\n"),
+  fputs (_("Usage: ypwhich [-d domain] [[-t] -m [mname]|[-Vn] hostname] | -x\n"
+	   "       ypwhich [-d domain] [-Vn] --hosts file [--timeout sec] [--sort]\n"),
 	 stream);
 }
 
@@ -86,6 +99,13 @@ print_help (void)
   fputs (_("  -x             Display the map nickname translation table\n"),
 	 stdout);
   fputs (_(" --verbose       Verbose output of result\n"), stdout);
+  fputs (_("      --hosts file  Ask ypbind on all hosts in 'file' at the same\n"
+	   "                 time, or on the hosts from stdin if 'file' is '-'\n"),
+	 stdout);
+  fputs (_("      --timeout sec  Time a host has to answer, default is 5\n"),
+	 stdout);
+  fputs (_("      --sort     Print the hosts sorted when all have answered\n"),
+	 stdout);
   fputs (_("  -?, --help     Give this help list\n"), stdout);
   fputs (_("      --usage    Give a short usage message\n"), stdout);
   fputs (_("      --version  Print program version\n"), stdout);
@@ -111,6 +131,12 @@ print_bindhost (char *hostname, char *domain, int vers)
   struct timeval tv;
   CLIENT *client;
 
+#if defined(HAVE_YPBIND3)
+  /* Don't try version 3 again if we know it fails */
+  if (vers == -1 && __yp_rpcvers_get (hostname, YPBINDPROG) == YPBINDVERS_2)
+    vers = YPBINDVERS_2;
+#endif
+
   client = clnt_create(hostname, YPBINDPROG, (vers==-1)?3:vers, "udp");
   if (client == NULL)
     {
@@ -177,11 +203,12 @@ print_bindhost (char *hostname, char *domain, int vers)
 	}
       clnt_destroy (client);
 
+      memset (&sa, 0, sizeof (sa));
       sa.sin_family = AF_INET;
       sa.sin_addr =  yp2_r.ypbind_respbody.ypbind_bindinfo.ypbind_binding_addr;
 
-      if (getnameinfo((struct sockaddr *)&sa, sizeof sa,
-		      host, sizeof host, NULL, 0, 0) == 0)
+      if (__yp_addr2name ((struct sockaddr *) &sa, sizeof sa,
+			  host, sizeof host) != NULL)
 	printf ("%s\n", host);
       else
 	{
@@ -207,7 +234,11 @@ print_bindhost (char *hostname, char *domain, int vers)
 
 	  /* if we have a RPC version mismatch, try version 2 */
 	  if (ret == RPC_PROGVERSMISMATCH && vers == -1)
-	    return print_bindhost (hostname, domain, 2);
+	    {
+	      clnt_destroy (client);
+	      __yp_rpcvers_set (hostname, YPBINDPROG, YPBINDVERS_2);
+	      return print_bindhost (hostname, domain, 2);
+	    }
 
 	  if (asprintf (&err, _("ypwhich: can't call ypbind on '%s'\n\t"),
 			hostname) > 0)
@@ -257,8 +288,12 @@ print_bindhost (char *hostname, char *domain, int vers)
 	  char hostbuf[NI_MAXHOST];
 	  const char *host;
 
-	  host = taddr2host (yp3_r.ypbind3_nconf, yp3_r.ypbind3_svcaddr,
-			     hostbuf, sizeof hostbuf);
+	  host = __yp_addr2name ((struct sockaddr *) yp3_r.ypbind3_svcaddr->buf,
+				 yp3_r.ypbind3_svcaddr->len,
+				 hostbuf, sizeof hostbuf);
+	  if (host == NULL)
+	    host = taddr2host (yp3_r.ypbind3_nconf, yp3_r.ypbind3_svcaddr,
+			       hostbuf, sizeof hostbuf);
 
 	  if (host)
 	    printf ("%s\n", host);
@@ -287,13 +322,454 @@ print_bindhost (char *hostname, char *domain, int vers)
   return 0;
 }
 
+/* State of one host with --hosts. First the port of ypbind is asked
+   from the portmapper, then ypbind itself.  */
+enum scan_state
+{
+  SCAN_PMAP,
+  SCAN_BIND3,
+  SCAN_BIND2
+};
+
+struct scan_host
+{
+  char *name;
+  enum scan_state state;
+  struct yp_hostaddr ha;
+  struct timeval deadline;
+  struct ypbind2_resp yp2_r;
+#if defined(HAVE_YPBIND3)
+  struct ypbind3_resp yp3_r;
+#endif
+  /* The server ypbind is bound to, or the error */
+  char *result;
+  int failed;
+};
+
+struct scan
+{
+  struct scan_host *hosts;
+  size_t nhosts;
+  size_t next;
+  /* Hosts waiting for the next call */
+  size_t *queue;
+  size_t nqueue;
+  char *domain;
+  int vers;
+  int sort;
+  struct timeval timeout;
+  int failed;
+};
+
+static void
+scan_print (struct scan_host *h)
+{
+  if (h->failed)
+    fprintf (stderr, "ypwhich: %s: %s\n", h->name, h->result);
+  else
+    printf ("%s %s\n", h->name, h->result);
+  fflush (stdout);
+}
+
+static void
+scan_finish (struct scan *sc, struct scan_host *h, int failed,
+	     const char *result)
+{
+  h->failed = failed;
+  h->result = strdup (result ? result : "");
+  if (failed)
+    sc->failed = 1;
+  if (!sc->sort)
+    {
+      scan_print (h);
+      free (h->result);
+      h->result = NULL;
+    }
+}
+
+static int
+scan_next (void *data, struct rpcpipe_call *call)
+{
+  struct scan *sc = data;
+  struct scan_host *h;
+  struct timeval now, left;
+
+  while (1)
+    {
+      if (sc->nqueue > 0)
+	{
+	  h = &sc->hosts[sc->queue[--sc->nqueue]];
+	  break;
+	}
+      if (sc->next >= sc->nhosts)
+	return 0;
+
+      h = &sc->hosts[sc->next++];
+      if (h->ha.error)
+	{
+	  scan_finish (sc, h, 1, yp_hostaddr_error (&h->ha));
+	  continue;
+	}
+      /* The time of the lookup counts, too.  */
+      if (!yp_hostaddr_left (&h->ha, &sc->timeout, &left))
+	{
+	  scan_finish (sc, h, 1, clnt_sperrno (RPC_TIMEDOUT));
+	  continue;
+	}
+      gettimeofday (&now, NULL);
+      timeradd (&now, &left, &h->deadline);
+      h->state = SCAN_PMAP;
+      break;
+    }
+
+  /* All calls for a host together have to be done in time.  */
+  gettimeofday (&now, NULL);
+  if (timercmp (&h->deadline, &now, >))
+    timersub (&h->deadline, &now, &call->timeout);
+  else
+    call->timeout.tv_usec = 1;
+
+  yp_hostaddr_setport (&h->ha, h->ha.port);
+  call->addr = (struct sockaddr *) &h->ha.addr;
+  call->addrlen = h->ha.addrlen;
+  call->data = h;
+
+  switch (h->state)
+    {
+    case SCAN_PMAP:
+      yp_hostaddr_getport (&h->ha, YPBINDPROG, 2, call);
+      break;
+#if defined(HAVE_YPBIND3)
+    case SCAN_BIND3:
+      memset (&h->yp3_r, 0, sizeof (h->yp3_r));
+      call->prog = YPBINDPROG;
+      call->vers = 3;
+      call->proc = YPBINDPROC_DOMAIN;
+      call->inproc = (xdrproc_t) xdr_domainname;
+      call->in = (caddr_t) &sc->domain;
+      call->outproc = (xdrproc_t) xdr_ypbind3_resp;
+      call->out = (caddr_t) &h->yp3_r;
+      break;
+#endif
+    default:
+      memset (&h->yp2_r, 0, sizeof (h->yp2_r));
+      call->prog = YPBINDPROG;
+      call->vers = (sc->vers == 1) ? 1 : 2;
+      call->proc = (sc->vers == 1) ? YPBINDPROC_OLDDOMAIN : YPBINDPROC_DOMAIN;
+      call->inproc = (xdrproc_t) xdr_domainname;
+      call->in = (caddr_t) &sc->domain;
+      call->outproc = (xdrproc_t) xdr_ypbind2_resp;
+      call->out = (caddr_t) &h->yp2_r;
+      break;
+    }
+
+  return 1;
+}
+
+static void
+scan_done (void *data, struct rpcpipe_call *call)
+{
+  struct scan *sc = data;
+  struct scan_host *h = call->data;
+
+  if (call->stat != RPC_SUCCESS)
+    {
+#if defined(HAVE_YPBIND3)
+      /* if we have a RPC version mismatch, try version 2 */
+      if (h->state == SCAN_BIND3 && call->stat == RPC_PROGVERSMISMATCH &&
+	  sc->vers == -1)
+	{
+	  h->state = SCAN_BIND2;
+	  sc->queue[sc->nqueue++] = h - sc->hosts;
+	  __yp_rpcvers_set (h->name, YPBINDPROG, YPBINDVERS_2);
+	  return;
+	}
+#endif
+      scan_finish (sc, h, 1, clnt_sperrno (call->stat));
+      return;
+    }
+
+  switch (h->state)
+    {
+    case SCAN_PMAP:
+      if (h->ha.port == 0 || h->ha.port > 0xffff)
+	{
+	  scan_finish (sc, h, 1, yperr_string (YPERR_YPBIND));
+	  return;
+	}
+#if defined(HAVE_YPBIND3)
+      if (sc->vers == 3 || (sc->vers == -1 &&
+			    __yp_rpcvers_get (h->name, YPBINDPROG) !=
+			    YPBINDVERS_2))
+	h->state = SCAN_BIND3;
+      else
+#endif
+	h->state = SCAN_BIND2;
+      sc->queue[sc->nqueue++] = h - sc->hosts;
+      return;
+#if defined(HAVE_YPBIND3)
+    case SCAN_BIND3:
+      if (h->yp3_r.ypbind_status != YPBIND_SUCC_VAL)
+	scan_finish (sc, h, 1, ypbinderr_string (h->yp3_r.ypbind3_error));
+      else if (h->yp3_r.ypbind3_servername &&
+	       strlen (h->yp3_r.ypbind3_servername) > 0)
+	scan_finish (sc, h, 0, h->yp3_r.ypbind3_servername);
+      else if (h->yp3_r.ypbind3_nconf && h->yp3_r.ypbind3_svcaddr)
+	{
+	  char hostbuf[NI_MAXHOST];
+	  const char *host;
+
+	  host = __yp_addr2name ((struct sockaddr *)
+				 h->yp3_r.ypbind3_svcaddr->buf,
+				 h->yp3_r.ypbind3_svcaddr->len,
+				 hostbuf, sizeof hostbuf);
+	  if (host == NULL)
+	    host = taddr2host (h->yp3_r.ypbind3_nconf,
+			       h->yp3_r.ypbind3_svcaddr,
+			       hostbuf, sizeof hostbuf);
+	  if (host)
+	    scan_finish (sc, h, 0, host);
+	  else
+	    scan_finish (sc, h, 1, _("taddr2host failed"));
+	}
+      else
+	scan_finish (sc, h, 1, _("no server information gotten from ypbind"));
+      xdr_free ((xdrproc_t) xdr_ypbind3_resp, (char *) &h->yp3_r);
+      return;
+#endif
+    default:
+      /* See print_bindhost for the test of the port */
+      if (h->yp2_r.ypbind_status != YPBIND_SUCC_VAL ||
+	  h->yp2_r.ypbind_respbody.ypbind_bindinfo.ypbind_binding_port == 0)
+	scan_finish (sc, h, 1,
+		     ypbinderr_string (h->yp2_r.ypbind_respbody.ypbind_error));
+      else
+	{
+	  struct sockaddr_in sa;
+	  char host[NI_MAXHOST];
+
+	  memset (&sa, 0, sizeof (sa));
+	  sa.sin_family = AF_INET;
+	  sa.sin_addr =
+	    h->yp2_r.ypbind_respbody.ypbind_bindinfo.ypbind_binding_addr;
+	  if (__yp_addr2name ((struct sockaddr *) &sa, sizeof sa,
+			      host, sizeof host) == NULL)
+	    inet_ntop (sa.sin_family, &sa.sin_addr, host, sizeof (host));
+	  scan_finish (sc, h, 0, host);
+	}
+      return;
+    }
+}
+
+static int
+scan_cmp (const void *a, const void *b)
+{
+  return strcmp (((const struct scan_host *) a)->name,
+		 ((const struct scan_host *) b)->name);
+}
+
+/* Ask ypbind on all hosts in file at the same time, which server
+   it is bound to, and print one line per host as the answers arrive,
+   or sorted by host name at the end.  */
+static int
+scan_hosts (const char *file, char *domain, int vers, int timeout, int sort)
+{
+  struct scan sc;
+  struct yp_hostaddr **ha;
+  struct rpcpipe *pipe;
+  char *line = NULL;
+  size_t linesize = 0, size = 0, i;
+  ssize_t n;
+  FILE *fp;
+  int ret;
+
+  memset (&sc, 0, sizeof (sc));
+  sc.domain = domain;
+  sc.vers = vers;
+  sc.sort = sort;
+  sc.timeout.tv_sec = timeout;
+
+  if (strcmp (file, "-") == 0)
+    fp = stdin;
+  else if ((fp = fopen (file, "r")) == NULL)
+    {
+      fprintf (stderr, _("ypwhich: can't open %s: %m\n"), file);
+      return 1;
+    }
+
+  while ((n = getline (&line, &linesize, fp)) >= 0)
+    {
+      char *p = line + strspn (line, " \t");
+
+      p[strcspn (p, " \t\r\n#")] = '\0';
+      if (*p == '\0')
+	continue;
+      if (sc.nhosts == size)
+	{
+	  struct scan_host *tmp;
+
+	  size = size ? 2 * size : 256;
+	  tmp = realloc (sc.hosts, size * sizeof (struct scan_host));
+	  if (tmp == NULL)
+	    {
+	      fputs (_("ypwhich: Out of memory\n"), stderr);
+	      return 1;
+	    }
+	  sc.hosts = tmp;
+	}
+      memset (&sc.hosts[sc.nhosts], 0, sizeof (struct scan_host));
+      if ((sc.hosts[sc.nhosts].name = strdup (p)) == NULL)
+	{
+	  fputs (_("ypwhich: Out of memory\n"), stderr);
+	  return 1;
+	}
+      sc.nhosts++;
+    }
+  free (line);
+  if (fp != stdin)
+    fclose (fp);
+
+  /* Many hosts are bound to the same few servers, and the next
+     scan will need the same names again.  */
+  __yp_addr2name_persist ();
+
+  sc.queue = calloc (sc.nhosts + 1, sizeof (size_t));
+  ha = calloc (sc.nhosts + 1, sizeof (struct yp_hostaddr *));
+  pipe = rpcpipe_open ();
+  if (sc.queue == NULL || ha == NULL || pipe == NULL)
+    {
+      fprintf (stderr, "ypwhich: %s\n", yperr_string (YPERR_RESRC));
+      return 1;
+    }
+
+  /* Look up all hosts first, a slow lookup in scan_next would stop
+     all calls in flight.  */
+  for (i = 0; i < sc.nhosts; i++)
+    {
+      sc.hosts[i].ha.name = sc.hosts[i].name;
+      ha[i] = &sc.hosts[i].ha;
+    }
+  yp_resolve_hosts (ha, sc.nhosts, &sc.timeout);
+  free (ha);
+
+  ret = rpcpipe_run (pipe, SCAN_WINDOW, scan_next, scan_done, &sc);
+  rpcpipe_destroy (pipe);
+  if (ret != 0)
+    sc.failed = 1;
+
+  if (sort)
+    {
+      qsort (sc.hosts, sc.nhosts, sizeof (struct scan_host), scan_cmp);
+      for (i = 0; i < sc.nhosts; i++)
+	if (sc.hosts[i].result != NULL)
+	  scan_print (&sc.hosts[i]);
+    }
+
+  for (i = 0; i < sc.nhosts; i++)
+    {
+      free (sc.hosts[i].name);
+      free (sc.hosts[i].result);
+    }
+  free (sc.hosts);
+  free (sc.queue);
+
+  return sc.failed;
+}
+
+static void
+print_master (const char *map, int ret, const char *master)
+{
+  if (ret == YPERR_SUCCESS)
+    printf ("%s %s\n", map, master);
+  else
+    fprintf (stderr, _("Can't find master for map %s. Reason: %s\n"),
+	     map, yperr_string (ret));
+}
+
+/* Ask the server ypbind is bound to for the master of all maps at
+   once. Returns -1 if this is not possible, so that the caller can
+   use yp_master.  */
+static int
+print_masters_pipelined (char *domain, struct ypmaplist *ypmap)
+{
+  struct ypreq_nokey *req;
+  struct ypresp_master *resp;
+  struct rpcpipe_call *calls;
+  struct rpcpipe *pipe;
+  struct ypmaplist *y;
+  size_t n = 0, i;
+  char *server;
+  int error, ret = -1;
+
+  server = __yp_bound_server (domain, &error);
+  if (server == NULL)
+    return -1;
+  pipe = rpcpipe_create (server, YPPROG, YPVERS);
+  free (server);
+  if (pipe == NULL)
+    return -1;
+
+  for (y = ypmap; y; y = y->next)
+    n++;
+  req = calloc (n, sizeof (struct ypreq_nokey));
+  resp = calloc (n, sizeof (struct ypresp_master));
+  calls = calloc (n, sizeof (struct rpcpipe_call));
+  if (req == NULL || resp == NULL || calls == NULL)
+    goto out;
+
+  for (y = ypmap, i = 0; y; y = y->next, i++)
+    {
+      req[i].domain = domain;
+      req[i].map = y->map;
+      calls[i].proc = YPPROC_MASTER;
+      calls[i].inproc = (xdrproc_t) xdr_ypreq_nokey;
+      calls[i].in = (caddr_t) &req[i];
+      calls[i].outproc = (xdrproc_t) xdr_ypresp_master;
+      calls[i].out = (caddr_t) &resp[i];
+      /* Calls which were not answered keep this.  */
+      calls[i].stat = RPC_TIMEDOUT;
+    }
+
+  if (rpcpipe_batch (pipe, calls, n, MASTER_WINDOW) != 0)
+    {
+      /* The caller asks again one by one, free what arrived.  */
+      for (i = 0; i < n; i++)
+	if (calls[i].stat == RPC_SUCCESS)
+	  xdr_free ((xdrproc_t) xdr_ypresp_master, (char *) &resp[i]);
+      goto out;
+    }
+  ret = 0;
+
+  /* Same errors as yp_master would return.  */
+  for (y = ypmap, i = 0; y; y = y->next, i++)
+    {
+      if (calls[i].stat != RPC_SUCCESS)
+	print_master (y->map, YPERR_RPC, NULL);
+      else
+	{
+	  error = ypprot_err (resp[i].status);
+	  if (error == YPERR_SUCCESS && resp[i].master == NULL)
+	    error = YPERR_RESRC;
+	  print_master (y->map, error, resp[i].master);
+	  xdr_free ((xdrproc_t) xdr_ypresp_master, (char *) &resp[i]);
+	}
+    }
+
+ out:
+  rpcpipe_destroy (pipe);
+  free (req);
+  free (resp);
+  free (calls);
+  return ret;
+}
 
 int
 main (int argc, char **argv)
 {
   int dflag = 0, mflag = 0, tflag = 0, Vflag = 0, xflag = 0, hflag = 0;
   char *hostname = NULL, *domainname = NULL, *mname = NULL;
-  int ypbind_version = -1;
+  const char *hostfile = NULL;
+  int ypbind_version = -1, timeout = SCAN_TIMEOUT, sort = 0, sflag = 0;
 
   setlocale (LC_MESSAGES, "");
   setlocale (LC_CTYPE, "");
@@ -309,6 +785,9 @@ main (int argc, char **argv)
         {"version", no_argument, NULL, '\255'},
         {"usage", no_argument, NULL, '\254'},
 	{"verbose", no_argument, NULL, '\253'},
+	{"hosts", required_argument, NULL, '\252'},
+	{"timeout", required_argument, NULL, '\251'},
+	{"sort", no_argument, NULL, '\250'},
         {"help", no_argument, NULL, '?'},
         {NULL, 0, NULL, '\0'}
       };
@@ -343,6 +822,22 @@ main (int argc, char **argv)
 	case '\253':
 	  verbose = 1;
 	  break;
+	case '\252':
+	  hostfile = optarg;
+	  break;
+	case '\251':
+	  sflag = 1;
+	  timeout = atoi (optarg);
+	  if (timeout < 1)
+	    {
+	      print_error ();
+	      return 1;
+	    }
+	  break;
+	case '\250':
+	  sflag = 1;
+	  sort = 1;
+	  break;
 	case '?':
 	  print_help ();
 	  return 0;
@@ -379,7 +874,8 @@ main (int argc, char **argv)
 
 
   if ((xflag && (dflag || mflag || tflag || Vflag || hflag)) ||
-      ((tflag || mflag) && (Vflag || hflag)) || (tflag && !mflag))
+      ((tflag || mflag) && (Vflag || hflag)) || (tflag && !mflag) ||
+      (hostfile && (xflag || mflag || hflag)) || (sflag && !hostfile))
     {
       print_error ();
       return 1;
@@ -441,25 +937,22 @@ main (int argc, char **argv)
 	  else
 	    { /* Show the master for all maps */
 	      struct ypmaplist *ypmap = NULL, *y, *old;
+	      int done;
 
 	      ret = yp_maplist (domainname, &ypmap);
 	      switch (ret)
 		{
 		case YPERR_SUCCESS:
+		  /* All at once if possible, else one after the other */
+		  done = (print_masters_pipelined (domainname, ypmap) == 0);
 		  for (y = ypmap; y;)
 		    {
-		      ret = yp_master (domainname, y->map, &master);
-		      switch (ret)
+		      if (!done)
 			{
-			case YPERR_SUCCESS:
-			  printf ("%s %s\n", y->map, master);
-			  free (master);
-			  break;
-			default:
-			  fprintf (stderr,
-			      _("Can't find master for map %s. Reason: %s\n"),
-				   y->map, yperr_string (ret));
-			  break;
+			  ret = yp_master (domainname, y->map, &master);
+			  print_master (y->map, ret, master);
+			  if (ret == YPERR_SUCCESS)
+			    free (master);
 			}
 		      old = y;
 		      y = y->next;
@@ -477,6 +970,8 @@ main (int argc, char **argv)
 		}
 	    }
 	}
+      else if (hostfile)
+	return scan_hosts (hostfile, domainname, ypbind_version, timeout, sort);
       else
 	{
 	  if (!hflag)